@@ -30,47 +30,49 @@
 
 #version 330 core
 
+struct DirLight
+{
+	vec3 direction;
+
+	vec3 ambient;
+	vec3 diffuse;
+	vec3 specular;
+};
+
+//! Per-frame data shared by all programs (std140, binding point 0)
+layout (std140) uniform FrameData
+{
+	mat4 u_projection;
+	mat4 u_view;
+	vec4 u_camPos;
+	DirLight dirLight;
+	DirLight dirLight2;
+	bool u_fog;
+	vec2 u_viewport;
+	float u_fogMin;		//! fog starts here (distance from the eye)
+	float u_fogMax;		//! and is opaque from here on
+};
+
 in vec3 FragCoord;
 in vec4 ViewSpace;
 
-uniform vec4 u_camPos;
-uniform bool u_fog;
-uniform int u_surface;
+flat in vec4 BezierColor;
 
 out vec4 FragColor;
 
 void main()
 {
-	//! Linear fog
-	vec3 distVector = vec3(ViewSpace) - vec3(u_camPos);
+	//! Linear fog (FOG permutation only)
+#ifdef FOG
+	vec3 distVector = vec3(ViewSpace);	//! the eye is at the origin in view space
 	float dist = length(distVector);
 
-	float minFogDist = 2.0f;
-	float maxFogDist = 17.0f;
-
-	float fogFactor = (maxFogDist - dist) / (maxFogDist - minFogDist);
+	float fogFactor = (u_fogMax - dist) / (u_fogMax - u_fogMin);
 	vec4 fogColor = vec4(0.3f, 0.3f, 0.3f, 1.0f);
 
-	vec4 bezierColor = vec4(0.0f, 0.6f, 0.7f, 1.0f);
-	switch (u_surface)
-	{
-	case 1:
-		bezierColor = vec4(0.0f, 0.63f, 0.95f, 1.0f);
-		break;
-	case 2:
-		bezierColor = vec4(1.0f, 0.73f, 0.0f, 1.0f);
-		break;
-	case 3:
-		bezierColor = vec4(0.48f, 0.73f, 0.0f, 1.0f);
-		break;
-	case 4:
-		bezierColor = vec4(0.96f, 0.325f, 0.08f, 1.0f);
-		break;
-	}
-
 	fogFactor = clamp(fogFactor, 0.0f, 1.0f);
-	if (u_fog)
-		FragColor = mix(fogColor, bezierColor, fogFactor);
-	else
-		FragColor = bezierColor;
+	FragColor = mix(fogColor, BezierColor, fogFactor);
+#else
+	FragColor = BezierColor;
+#endif
 }
@@ -30,40 +30,50 @@
 
 #version 330 core
 
+struct DirLight
+{
+	vec3 direction;
+
+	vec3 ambient;
+	vec3 diffuse;
+	vec3 specular;
+};
+
+//! Per-frame data shared by all programs (std140, binding point 0)
+layout (std140) uniform FrameData
+{
+	mat4 u_projection;
+	mat4 u_view;
+	vec4 u_camPos;
+	DirLight dirLight;
+	DirLight dirLight2;
+	bool u_fog;
+	vec2 u_viewport;
+	float u_fogMin;		//! fog starts here (distance from the eye)
+	float u_fogMax;		//! and is opaque from here on
+};
+
 in vec3 FragCoord;
 in vec4 ViewSpace;
-
-uniform vec4 u_camPos;
-uniform bool u_destroyed;
-uniform int  u_bboxColor;
-uniform bool u_fog;
+flat in vec4 BoundingBoxColor;
 
 out vec4 FragColor;
 
 void main()
 {
-	//! Linear fog
-	vec3 distVector = vec3(ViewSpace) - vec3(u_camPos);
-	float dist = length(distVector);
+	vec4 boundingBoxColor = BoundingBoxColor;
 
-	float minFogDist = 2.0f;
-	float maxFogDist = 17.0f;
+	//! Linear fog (FOG permutation only)
+#ifdef FOG
+	vec3 distVector = vec3(ViewSpace);	//! the eye is at the origin in view space
+	float dist = length(distVector);
 
-	float fogFactor = (maxFogDist - dist) / (maxFogDist - minFogDist);
+	float fogFactor = (u_fogMax - dist) / (u_fogMax - u_fogMin);
 	vec4 fogColor = vec4(0.3f, 0.3f, 0.3f, 1.0f);
 
-	vec4 boundingBoxColor = vec4(0.0f, 0.0f, 0.0f, 1.0f);
-
-	if (u_bboxColor == 1)
-		boundingBoxColor = vec4(1.0f, 1.0f, 1.0f, 1.0f);	//! white
-	else if (u_bboxColor == 2)
-		boundingBoxColor = vec4(0.0f, 1.0f, 0.0f, 1.0f);	//! green
-	else if (u_bboxColor == 3)
-		boundingBoxColor = vec4(1.0f, 0.0f, 0.0f, 1.0f);	//! red
-
 	fogFactor = clamp(fogFactor, 0.0f, 1.0f);
-	if (u_fog)
-	 FragColor = mix(fogColor, boundingBoxColor, fogFactor);
-	else
-	 FragColor = boundingBoxColor;
+	FragColor = mix(fogColor, boundingBoxColor, fogFactor);
+#else
+	FragColor = boundingBoxColor;
+#endif
 }
@@ -25,25 +25,12 @@
  * SOFTWARE.
  *
  * @section DESCRIPTION
- * Grid Small Vertex Shader.
+ * Depth-only Fragment Shader (depth pre-pass).
  **/
 
 #version 330 core
 
-layout (location = 0) in vec3 a_pos;
-layout (location = 1) in vec3 a_normal;
-
-uniform mat4 u_projection;
-uniform mat4 u_modelView;
-
-out vec3 Normal;
-out vec3 FragCoord;
-out vec4 ViewSpace;
-
+//! No colour outputs; only the depth of the fragment is written
 void main()
 {
-	gl_Position = u_projection * u_modelView * vec4(a_pos, 1.0f);
-	ViewSpace = u_modelView * vec4(a_pos, 1.0f);
-	FragCoord = a_pos;
-	Normal = a_normal;
 }
@@ -25,7 +25,7 @@
  * SOFTWARE.
  *
  * @section DESCRIPTION
- * Grid Small Fragment Shader.
+ * Grid Fragment Shader.
  **/
 
 #version 330 core
@@ -39,42 +39,72 @@ struct DirLight
 	vec3 specular;
 };
 
+//! Per-frame data shared by all programs (std140, binding point 0)
+layout (std140) uniform FrameData
+{
+	mat4 u_projection;
+	mat4 u_view;
+	vec4 u_camPos;
+	DirLight dirLight;
+	DirLight dirLight2;
+	bool u_fog;
+	vec2 u_viewport;
+	float u_fogMin;		//! fog starts here (distance from the eye)
+	float u_fogMax;		//! and is opaque from here on
+};
+
 vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir);
 
-in vec3 Normal;
 in vec3 FragCoord;
 in vec4 ViewSpace;
 
-uniform DirLight dirLight2;
-uniform vec4 u_camPos;
-uniform bool u_fog;
+//! Tiles are 2x2 cells centred on even coordinates; the lit tile covers the
+//! inner 1.6x1.6 and the rest of the cell shows the black background
+const float tileHalfSize = 0.8f;
+
+//! Corner normals of the tile's top face are (+-c, +-c, c)
+const float cornerNormal = 0.5774f;
 
 out vec4 FragColor;
 
 void main()
 {
+	//! Position within the current cell, in [-1, 1)
+	vec2 cell = mod(FragCoord.xy + 1.0f, 2.0f) - 1.0f;
+
+	//! Signed distance to the tile's edge (positive in the gap); fwidth keeps the edge antialiased
+	vec2 edgeDist = abs(cell) - tileHalfSize;
+	float edge = max(edgeDist.x, edgeDist.y);
+	float aa = fwidth(edge);
+	float tileMask = 1.0f - smoothstep(-aa, aa, edge);
+
+	//! Corner normals interpolated across the top face (and remapped into [0, 1] as loaded normals are)
+	vec2 corner = clamp(cell / tileHalfSize, -1.0f, 1.0f);
+	vec3 normal = vec3(corner * cornerNormal, cornerNormal) * 0.5f + 0.5f;
+
 	//! Directional lighting
-	vec3 viewDirection = normalize(vec3(u_camPos.x, u_camPos.y, u_camPos.z) - vec3(ViewSpace.x, ViewSpace.y, ViewSpace.z));
+	vec3 viewDirection = normalize(-vec3(ViewSpace));
 
 	vec4 tileColor = vec4(0.0f, 0.0f, 0.0f, 1.0f);
-	tileColor += vec4(CalcDirLight(dirLight2, normalize(Normal), viewDirection), 0.0f);
+	tileColor += vec4(CalcDirLight(dirLight2, normalize(normal), viewDirection), 0.0f);
 
-	//! Linear fog
-	vec3 distVector = vec3(ViewSpace) - vec3(u_camPos);
-	float dist = length(distVector);
+	//! Black background between tiles
+	tileColor = mix(vec4(0.0f, 0.0f, 0.0f, 1.0f), tileColor, tileMask);
 
-	float minFogDist = 2.0f;
-	float maxFogDist = 17.0f;
+	//! Linear fog (FOG permutation only)
+#ifdef FOG
+	vec3 distVector = vec3(ViewSpace);	//! the eye is at the origin in view space
+	float dist = length(distVector);
 
-	float fogFactor = (maxFogDist - dist) / (maxFogDist - minFogDist);
+	float fogFactor = (u_fogMax - dist) / (u_fogMax - u_fogMin);
 
 	vec4 fogColor = vec4(0.3f, 0.3f, 0.3f, 1.0f);		//! grey
 
 	fogFactor = clamp(fogFactor, 0.0f, 1.0f);
-	if (u_fog)
-		FragColor = mix(fogColor, tileColor, fogFactor);
-	else
-		FragColor = tileColor;
+	FragColor = mix(fogColor, tileColor, fogFactor);
+#else
+	FragColor = tileColor;
+#endif
 }
 
 // Calculates the color when using a directional light.
@@ -39,6 +39,33 @@ struct DirLight
 	vec3 specular;
 };
 
+//! Per-frame data shared by all programs (std140, binding point 0)
+layout (std140) uniform FrameData
+{
+	mat4 u_projection;
+	mat4 u_view;
+	vec4 u_camPos;
+	DirLight dirLight;
+	DirLight dirLight2;
+	bool u_fog;
+	vec2 u_viewport;
+	float u_fogMin;		//! fog starts here (distance from the eye)
+	float u_fogMax;		//! and is opaque from here on
+};
+
+struct Material
+{
+	vec3 ambient;
+	vec3 diffuse;
+	vec3 specular;
+};
+
+//! Material table shared by all programs (std140, binding point 1, MAX_MATERIALS entries)
+layout (std140) uniform Materials
+{
+	Material u_materials[16];
+};
+
 vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir);
 
 in vec3 Normal;
@@ -53,17 +80,14 @@ const vec3 RimColor = vec3(0.2f, 0.2f, 0.2f);
 
 const float gamma = 1.0f / 0.3f;
 
-uniform DirLight dirLight;
-uniform vec4 u_camPos;
-uniform int u_obstacleType;
-uniform bool u_fog;
+flat in int MaterialIndex;
 
 out vec4 FragColor;
 
 void main()
 {
 	// Directional Lighting
-	vec3 viewDirection = normalize(vec3(u_camPos.x, u_camPos.y, u_camPos.z) - vec3(ViewSpace.x, ViewSpace.y, ViewSpace.z));
+	vec3 viewDirection = normalize(-vec3(ViewSpace));
 
 	vec4 obstacleColor = vec4(0.0f, 0.0f, 0.0f, 1.0f);
 	obstacleColor += vec4(CalcDirLight(dirLight, normalize(Normal), viewDirection), 0.0f);
@@ -78,22 +102,20 @@ void main()
 
 	vec3 finalColorGamma  = vec3(pow(finalColor.r, gamma), pow(finalColor.g, gamma), pow(finalColor.b, gamma));
 
-	//! Linear fog
-	vec3 distVector = vec3(ViewSpace) - vec3(u_camPos);
+	//! Linear fog (FOG permutation only)
+#ifdef FOG
+	vec3 distVector = vec3(ViewSpace);	//! the eye is at the origin in view space
 	float dist = length(distVector);
 
-	float minFogDist = 2.0f;
-	float maxFogDist = 17.0f;
-
-	float fogFactor = (maxFogDist - dist) / (maxFogDist - minFogDist);
+	float fogFactor = (u_fogMax - dist) / (u_fogMax - u_fogMin);
   
 	vec4 fogColor = vec4(0.3f, 0.3f, 0.3f, 1.0f);		//! grey
 
 	fogFactor = clamp(fogFactor, 0.0f, 1.0f);
-	if (u_fog)
-		FragColor = mix(fogColor, vec4(finalColorGamma, 1), fogFactor);
-	else
-		FragColor = vec4(finalColorGamma, 1);
+	FragColor = mix(fogColor, vec4(finalColorGamma, 1), fogFactor);
+#else
+	FragColor = vec4(finalColorGamma, 1);
+#endif
 }
 
 //! Calculates the color when using a directional light.
@@ -109,31 +131,11 @@ vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir)
 	float spec = pow(max(dot(viewDir, reflectDir), 0.0f), 0.9f);
 
 	//! Combine results
-	vec3 ambient, diffuse, specular;
-
-	//! pyramid
-	if (u_obstacleType == 1)
-	{
-		ambient = light.ambient * vec3(0.135f, 0.2225f, 0.1575f);
-		diffuse = light.diffuse * diff * vec3(0.54f, 0.89f, 0.63f);
-		specular = light.specular * spec * vec3(0.5f, 0.5f, 0.5f) * dot(vec3(0.5f, 0.5f, 0.5f), light.specular);
-	}
-
-	//! coin
-	else if (u_obstacleType == 2)
-	{
-		ambient = light.ambient * vec3(0.24725f, 0.1995f, 0.0745f);
-		diffuse = light.diffuse * diff * vec3(0.75164f, 0.60648f, 0.22648f);
-		specular = light.specular * spec * vec3(0.628281f, 0.555802f, 0.366065f) * dot(vec3(0.628281f, 0.555802f, 0.366065f), light.specular);
-	}
-
-	//! wall
-	else if (u_obstacleType == 3)
-	{
-		ambient = light.ambient * vec3(0.25f, 0.25f, 0.25f);
-		diffuse = light.diffuse * diff * vec3(0.4f, 0.4f, 0.4f);
-		specular = light.specular * spec * vec3(0.774597f, 0.774597f, 0.774597f) * dot(vec3(0.774597f, 0.774597f, 0.774597f), light.specular);
-	}
+	Material material = u_materials[MaterialIndex];
+
+	vec3 ambient = light.ambient * material.ambient;
+	vec3 diffuse = light.diffuse * diff * material.diffuse;
+	vec3 specular = light.specular * spec * material.specular * dot(material.specular, light.specular);
 
 	return (ambient + diffuse + specular);
 }
@@ -33,48 +33,56 @@
 struct DirLight
 {
 	vec3 direction;
-  
+
 	vec3 ambient;
 	vec3 diffuse;
 	vec3 specular;
 };
 
+//! Per-frame data shared by all programs (std140, binding point 0)
+layout (std140) uniform FrameData
+{
+	mat4 u_projection;
+	mat4 u_view;
+	vec4 u_camPos;
+	DirLight dirLight;
+	DirLight dirLight2;
+	bool u_fog;
+	vec2 u_viewport;
+	float u_fogMin;		//! fog starts here (distance from the eye)
+	float u_fogMax;		//! and is opaque from here on
+};
+
 vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir);
 
 in vec3 Normal;
 in vec3 FragCoord;
 in vec4 ViewSpace;
 
-uniform DirLight dirLight;
-uniform vec4 u_camPos;
-uniform bool u_fog;
-
 out vec4 FragColor;
 
 void main()
 {
 	// Directional Lighting
-	vec3 viewDirection = normalize(vec3(u_camPos.x, u_camPos.y, u_camPos.z) - vec3(ViewSpace.x, ViewSpace.y, ViewSpace.z));
+	vec3 viewDirection = normalize(-vec3(ViewSpace));
 
 	vec4 snakeColor = vec4(0.0f, 0.0f, 0.0f, 1.0f);	//! red
 	snakeColor += vec4(CalcDirLight(dirLight, normalize(Normal), viewDirection), 0.0f);
 
-	//! Linear fog
-	vec3 distVector = vec3(ViewSpace) - vec3(u_camPos);
+	//! Linear fog (FOG permutation only)
+#ifdef FOG
+	vec3 distVector = vec3(ViewSpace);	//! the eye is at the origin in view space
 	float dist = length(distVector);
 
-	float minFogDist = 2.0f;
-	float maxFogDist = 17.0f;
-
-	float fogFactor = (maxFogDist - dist) / (maxFogDist - minFogDist);
+	float fogFactor = (u_fogMax - dist) / (u_fogMax - u_fogMin);
 
 	vec4 fogColor = vec4(0.3f, 0.3f, 0.3f, 1.0f);		//! grey
 
 	fogFactor = clamp(fogFactor, 0.0f, 1.0f);
-	if (u_fog)
-		FragColor = mix(fogColor, snakeColor, fogFactor);
-	else
-		FragColor = snakeColor;
+	FragColor = mix(fogColor, snakeColor, fogFactor);
+#else
+	FragColor = snakeColor;
+#endif
 }
 
 //! Calculates the color when using a directional light.
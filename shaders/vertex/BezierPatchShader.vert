@@ -25,22 +25,20 @@
  * SOFTWARE.
  *
  * @section DESCRIPTION
- * Grid Big Vertex Shader.
+ * Bezier Patch Vertex Shader (tessellation path).
  **/
 
-#version 330 core
+#version 400 core
 
 layout (location = 0) in vec3 a_pos;
+layout (location = 1) in int a_surface;
 
-uniform mat4 u_projection;
-uniform mat4 u_modelView;
-
-out vec3 FragCoord;
-out vec4 ViewSpace;
+out vec3 ControlPoint;
+flat out int Surface;
 
 void main()
 {
-	gl_Position = u_projection * u_modelView * vec4(a_pos, 1.0f);
-	ViewSpace = u_modelView * vec4(a_pos, 1.0f);
-	FragCoord = a_pos;
+	//! Control points are passed through untouched; the TES evaluates the surface
+	ControlPoint = a_pos;
+	Surface = a_surface;
 }
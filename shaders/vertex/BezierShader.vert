@@ -30,17 +30,61 @@
 
 #version 330 core
 
+struct DirLight
+{
+	vec3 direction;
+
+	vec3 ambient;
+	vec3 diffuse;
+	vec3 specular;
+};
+
+//! Per-frame data shared by all programs (std140, binding point 0)
+layout (std140) uniform FrameData
+{
+	mat4 u_projection;
+	mat4 u_view;
+	vec4 u_camPos;
+	DirLight dirLight;
+	DirLight dirLight2;
+	bool u_fog;
+	vec2 u_viewport;
+	float u_fogMin;		//! fog starts here (distance from the eye)
+	float u_fogMax;		//! and is opaque from here on
+};
+
 layout (location = 0) in vec3 a_pos;
+layout (location = 1) in int a_surface;
 
-uniform mat4 projection;
-uniform mat4 modelView;
+uniform mat4 u_modelView;
 
 out vec3 FragCoord;
 out vec4 ViewSpace;
+flat out vec4 BezierColor;
+
+//! Same depth in the pre-pass (DepthShader.frag) and the GL_EQUAL shading pass
+invariant gl_Position;
 
 void main()
 {
-	gl_Position = projection * modelView * vec4(a_pos, 1.0f);
-	ViewSpace = modelView * vec4(a_pos, 1.0f);
+	gl_Position = u_projection * u_modelView * vec4(a_pos, 1.0f);
+	ViewSpace = u_modelView * vec4(a_pos, 1.0f);
 	FragCoord = a_pos;
+
+	BezierColor = vec4(0.0f, 0.6f, 0.7f, 1.0f);
+	switch (a_surface)
+	{
+	case 1:
+		BezierColor = vec4(0.0f, 0.63f, 0.95f, 1.0f);
+		break;
+	case 2:
+		BezierColor = vec4(1.0f, 0.73f, 0.0f, 1.0f);
+		break;
+	case 3:
+		BezierColor = vec4(0.48f, 0.73f, 0.0f, 1.0f);
+		break;
+	case 4:
+		BezierColor = vec4(0.96f, 0.325f, 0.08f, 1.0f);
+		break;
+	}
 }
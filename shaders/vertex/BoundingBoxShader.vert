@@ -30,17 +30,54 @@
 
 #version 330 core
 
-layout (location = 0) in vec3 a_pos;
+struct DirLight
+{
+	vec3 direction;
+
+	vec3 ambient;
+	vec3 diffuse;
+	vec3 specular;
+};
+
+//! Per-frame data shared by all programs (std140, binding point 0)
+layout (std140) uniform FrameData
+{
+	mat4 u_projection;
+	mat4 u_view;
+	vec4 u_camPos;
+	DirLight dirLight;
+	DirLight dirLight2;
+	bool u_fog;
+	vec2 u_viewport;
+	float u_fogMin;		//! fog starts here (distance from the eye)
+	float u_fogMax;		//! and is opaque from here on
+};
+
+layout (location = 0) in vec3 a_corner;	//! unit cube corner
+layout (location = 1) in vec3 a_min;		//! per-instance box extents
+layout (location = 2) in vec3 a_max;
+layout (location = 3) in int  a_color;		//! 1 for white, 2 for green, 3 for red
 
-uniform mat4 u_projection;
 uniform mat4 u_modelView;
 
 out vec3 FragCoord;
 out vec4 ViewSpace;
+flat out vec4 BoundingBoxColor;
 
 void main()
 {
-	gl_Position = u_projection * u_modelView * vec4(a_pos, 1.0f);
-	ViewSpace = u_modelView * vec4(a_pos, 1.0f);
-	FragCoord = a_pos;
+	vec3 pos = mix(a_min, a_max, a_corner);
+
+	gl_Position = u_projection * u_modelView * vec4(pos, 1.0f);
+	ViewSpace = u_modelView * vec4(pos, 1.0f);
+	FragCoord = pos;
+
+	BoundingBoxColor = vec4(0.0f, 0.0f, 0.0f, 1.0f);
+
+	if (a_color == 1)
+		BoundingBoxColor = vec4(1.0f, 1.0f, 1.0f, 1.0f);	//! white
+	else if (a_color == 2)
+		BoundingBoxColor = vec4(0.0f, 1.0f, 0.0f, 1.0f);	//! green
+	else if (a_color == 3)
+		BoundingBoxColor = vec4(1.0f, 0.0f, 0.0f, 1.0f);	//! red
 }
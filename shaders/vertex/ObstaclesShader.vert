@@ -30,11 +30,34 @@
 
 #version 330 core
 
+struct DirLight
+{
+	vec3 direction;
+
+	vec3 ambient;
+	vec3 diffuse;
+	vec3 specular;
+};
+
+//! Per-frame data shared by all programs (std140, binding point 0)
+layout (std140) uniform FrameData
+{
+	mat4 u_projection;
+	mat4 u_view;
+	vec4 u_camPos;
+	DirLight dirLight;
+	DirLight dirLight2;
+	bool u_fog;
+	vec2 u_viewport;
+	float u_fogMin;		//! fog starts here (distance from the eye)
+	float u_fogMax;		//! and is opaque from here on
+};
+
 layout (location = 0) in vec3 a_pos;
 layout (location = 1) in vec3 a_normal;
+layout (location = 2) in mat4 a_modelView;	//! per-instance (locations 2-5)
 
-uniform mat4 u_projection;
-uniform mat4 u_modelView;
+layout (location = 6) in int a_material;	//! per-instance index into the material table
 
 out vec3 Normal;
 out vec3 FragCoord;
@@ -42,13 +65,18 @@ out vec4 ViewSpace;
 
 out vec3 WorldPos;
 out vec3 WorldNormal;
+flat out int MaterialIndex;
+
+//! Same depth in the pre-pass (DepthShader.frag) and the GL_EQUAL shading pass
+invariant gl_Position;
 
 void main()
 {
-	gl_Position = u_projection * u_modelView * vec4(a_pos, 1.0f);
-	ViewSpace = u_modelView * vec4(a_pos, 1.0f);
+	gl_Position = u_projection * a_modelView * vec4(a_pos, 1.0f);
+	ViewSpace = a_modelView * vec4(a_pos, 1.0f);
 	FragCoord = a_pos;
-	Normal = a_normal;
-	WorldPos = mat3(u_modelView) * a_pos;
-	WorldNormal = normalize(mat3(u_modelView) * a_normal);
+	Normal = a_normal * 0.5f + 0.5f;	//! lighting is tuned for normals remapped to [0,1]
+	WorldPos = mat3(a_modelView) * a_pos;
+	WorldNormal = normalize(mat3(a_modelView) * Normal);
+	MaterialIndex = a_material;
 }
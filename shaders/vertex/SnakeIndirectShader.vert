@@ -0,0 +1,92 @@
+/**
+ * @file This file is part of snakesGL.
+ *
+ * @section LICENSE
+ * MIT License
+ *
+ * Copyright (c) 2018-2019 Rajdeep Konwar, Luke Rohrer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @section DESCRIPTION
+ * Snake Vertex Shader (GPU-driven path).
+ **/
+
+#version 430 core
+
+struct DirLight
+{
+	vec3 direction;
+
+	vec3 ambient;
+	vec3 diffuse;
+	vec3 specular;
+};
+
+//! Per-frame data shared by all programs (std140, binding point 0)
+layout (std140) uniform FrameData
+{
+	mat4 u_projection;
+	mat4 u_view;
+	vec4 u_camPos;
+	DirLight dirLight;
+	DirLight dirLight2;
+	bool u_fog;
+	vec2 u_viewport;
+	float u_fogMin;		//! fog starts here (distance from the eye)
+	float u_fogMax;		//! and is opaque from here on
+};
+
+//! Per-object record written by the CPU, read by culling and drawing (std430, binding 0)
+struct Object
+{
+	mat4 model;
+	vec4 boundsMin;		//! local-space AABB of the mesh
+	vec4 boundsMax;
+	uint mesh;			//! index of the draw command
+	int type;			//! obstacle type (1 pyramid, 2 coin, 3 wall)
+	uint destroyed;
+	uint pad;
+};
+
+layout (std430, binding = 0) readonly buffer Objects
+{
+	Object objects[];
+};
+
+layout (location = 0) in vec3 a_pos;
+layout (location = 1) in vec3 a_normal;
+layout (location = 6) in uint a_objectId;	//! per-instance; honours the command's baseInstance
+
+out vec3 Normal;
+out vec3 FragCoord;
+out vec4 ViewSpace;
+
+//! Same depth in the pre-pass (DepthShader.frag) and the GL_EQUAL shading pass
+invariant gl_Position;
+
+void main()
+{
+	mat4 modelView = u_view * objects[a_objectId].model;
+
+	gl_Position = u_projection * modelView * vec4(a_pos, 1.0f);
+	ViewSpace = modelView * vec4(a_pos, 1.0f);
+	FragCoord = a_pos;
+	Normal = a_normal * 0.5f + 0.5f;	//! lighting is tuned for normals remapped to [0,1]
+}
@@ -28,104 +28,173 @@
  * Bezier Surface.
  **/
 
+#include <cstddef>
+
 #include "Bezier.h"
 #include "Window.h"
 
-Bezier::Bezier(const glm::vec3 points[16])
+Bezier::Bezier(bool tessellate) : m_tessellate(tessellate)
 {
-	m_G[0] = glm::mat4( glm::vec4( points[0].x, points[4].x, points[8].x,  points[12].x ),
+	m_B = glm::mat4(glm::vec4( -1.0f,  3.0f, -3.0f, 1.0f ),
+					glm::vec4(  3.0f, -6.0f,  3.0f, 0.0f ),
+					glm::vec4( -3.0f,  3.0f,  0.0f, 0.0f ),
+					glm::vec4(  1.0f,  0.0f,  0.0f, 0.0f ));
+
+	// Every patch is the same (n + 1) x (n + 1) grid, so one index list serves them all
+	if (!m_tessellate)
+	{
+		constexpr int n = BEZIER_RESOLUTION;
+		for (int row = 0; row < n; row++)
+		{
+			for (int col = 0; col < n; col++)
+			{
+				GLushort i0 = static_cast<GLushort>(row * (n + 1) + col);
+				GLushort i1 = static_cast<GLushort>(i0 + 1);
+				GLushort i2 = static_cast<GLushort>(i0 + n + 1);
+				GLushort i3 = static_cast<GLushort>(i2 + 1);
+
+				m_indices.push_back(i0);	m_indices.push_back(i2);	m_indices.push_back(i1);
+				m_indices.push_back(i1);	m_indices.push_back(i2);	m_indices.push_back(i3);
+			}
+		}
+	}
+
+	glGenVertexArrays(1, &m_VAO);
+	glGenBuffers(1, &m_VBO);
+	glGenBuffers(1, &m_EBO);
+}
+
+Bezier::~Bezier()
+{
+	GLState::deleteVertexArrays(1, &m_VAO);
+
+	GLState::deleteBuffers(1, &m_VBO);
+	GLState::deleteBuffers(1, &m_EBO);
+}
+
+// Tessellation shaders are core since OpenGL 4.0
+bool Bezier::tessellationSupported()
+{
+	GLint major = 0;
+	glGetIntegerv(GL_MAJOR_VERSION, &major);
+
+	return major >= 4;
+}
+
+void Bezier::addPatch(const glm::vec3 points[16], int surface)
+{
+	// A Bezier patch lies inside the convex hull of its control points
+	for (int i = 0; i < BEZIER_CONTROL_POINTS; i++)
+		m_bounds.merge(points[i]);
+
+	if (m_tessellate)
+	{
+		for (int i = 0; i < BEZIER_CONTROL_POINTS; i++)
+		{
+			Vertex controlPoint;
+			controlPoint.pos = points[i];
+			controlPoint.surface = surface;
+			m_controlPoints.push_back(controlPoint);
+		}
+
+		return;
+	}
+
+	glm::mat4 G[3], C[3];
+
+	G[0] = glm::mat4(	glm::vec4( points[0].x, points[4].x, points[8].x,  points[12].x ),
 						glm::vec4( points[1].x, points[5].x, points[9].x,  points[13].x ),
 						glm::vec4( points[2].x, points[6].x, points[10].x, points[14].x ),
 						glm::vec4( points[3].x, points[7].x, points[11].x, points[15].x ) );
 
-	m_G[1] = glm::mat4( glm::vec4( points[0].y, points[4].y, points[8].y,  points[12].y ),
+	G[1] = glm::mat4(	glm::vec4( points[0].y, points[4].y, points[8].y,  points[12].y ),
 						glm::vec4( points[1].y, points[5].y, points[9].y,  points[13].y ),
 						glm::vec4( points[2].y, points[6].y, points[10].y, points[14].y ),
 						glm::vec4( points[3].y, points[7].y, points[11].y, points[15].y ) );
 
-	m_G[2] = glm::mat4( glm::vec4( points[0].z, points[4].z, points[8].z,  points[12].z ),
+	G[2] = glm::mat4(	glm::vec4( points[0].z, points[4].z, points[8].z,  points[12].z ),
 						glm::vec4( points[1].z, points[5].z, points[9].z,  points[13].z ),
 						glm::vec4( points[2].z, points[6].z, points[10].z, points[14].z ),
 						glm::vec4( points[3].z, points[7].z, points[11].z, points[15].z ) );
 
-	m_B = glm::mat4(glm::vec4( -1.0f,  3.0f, -3.0f, 1.0f ),
-					glm::vec4(  3.0f, -6.0f,  3.0f, 0.0f ),
-					glm::vec4( -3.0f,  3.0f,  0.0f, 0.0f ),
-					glm::vec4(  1.0f,  0.0f,  0.0f, 0.0f ));
-
-	m_C[0] = m_B * m_G[0] * m_B;
-	m_C[1] = m_B * m_G[1] * m_B;
-	m_C[2] = m_B * m_G[2] * m_B;
+	C[0] = m_B * G[0] * m_B;
+	C[1] = m_B * G[1] * m_B;
+	C[2] = m_B * G[2] * m_B;
 
-	int counter = 0;
-	int rows = 0;
+	m_counts.push_back(static_cast<GLsizei>(m_indices.size()));
+	m_offsets.push_back((const GLvoid *)0);
+	m_baseVertices.push_back(static_cast<GLint>(m_vertices.size()));
 
-	float u = 0.0f;
-	float v = 0.0f;
-
-	while (rows <= 100)
+	// Evaluate x(u, v) on a regular grid; rows run along v, columns along u
+	constexpr int n = BEZIER_RESOLUTION;
+	for (int row = 0; row <= n; row++)
 	{
-		while (counter < 202)
+		float v = static_cast<float>(row) / n;
+		glm::vec4 vVector = glm::vec4(v * v * v, v * v, v, 1);
+
+		for (int col = 0; col <= n; col++)
 		{
+			float u = static_cast<float>(col) / n;
 			glm::vec4 uVector = glm::vec4(u * u * u, u * u, u, 1);
-			glm::vec4 vVector = glm::vec4(v * v * v, v * v, v, 1);
-
-			glm::vec3 xOfuv	= glm::vec3(glm::dot(vVector, m_C[0] * uVector),
-										glm::dot(vVector, m_C[1] * uVector),
-										glm::dot(vVector, m_C[2] * uVector));
-
-			m_vertices[rows].push_back(xOfuv);
-
-			if (counter % 2 == 0)
-				u += 0.01f;
-			else
-			{
-				u -= 0.01f;
-				v += 0.01f;
-			}
 
-			counter++;
+			Vertex vertex;
+			vertex.pos = glm::vec3(	glm::dot(vVector, C[0] * uVector),
+									glm::dot(vVector, C[1] * uVector),
+									glm::dot(vVector, C[2] * uVector));
+			vertex.surface = surface;
+			m_vertices.push_back(vertex);
 		}
-
-		counter = 0;
-		v = 0.0f;
-		u = 0.0f + rows * 0.01f;
-		rows++;
 	}
+}
 
-	for (int j = 0; j <= 100; j++)
-	{
-		glGenVertexArrays(1, &m_VAO[j]);
-		glGenBuffers(1, &m_VBO[j]);
+void Bezier::upload()
+{
+	const std::vector<Vertex> &vertices = m_tessellate ? m_controlPoints : m_vertices;
+
+	GLState::bindVertexArray(m_VAO);
 
-		glBindVertexArray(m_VAO[j]);
-		glBindBuffer(GL_ARRAY_BUFFER, m_VBO[j]);
-		glBufferData(GL_ARRAY_BUFFER, m_vertices[j].size() * sizeof(glm::vec3), &m_vertices[j][0], GL_STATIC_DRAW);
+	GLState::bindBuffer(GL_ARRAY_BUFFER, m_VBO);
+	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
 
-		glEnableVertexAttribArray(0);
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (GLvoid*)0);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLvoid *)offsetof(Vertex, pos));
+	glEnableVertexAttribArray(1);
+	glVertexAttribIPointer(1, 1, GL_INT, sizeof(Vertex), (GLvoid *)offsetof(Vertex, surface));
 
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
-		glBindVertexArray(0);
+	if (!m_tessellate)
+	{
+		GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_indices.size() * sizeof(GLushort), &m_indices[0], GL_STATIC_DRAW);
 	}
+
+	GLState::bindBuffer(GL_ARRAY_BUFFER, 0);
+	GLState::bindVertexArray(0);
 }
 
-void Bezier::draw(const GLuint &shaderProgram)
+void Bezier::draw(Shader &shader, const glm::mat4 &mtx)
 {
-	glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, &Window::m_P[0][0]);
-	glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "modelView"), 1, GL_FALSE, &Window::m_V[0][0]);
-	glUniform1i(glGetUniformLocation(shaderProgram, "u_surface"), m_surface);
+	RenderQueue::submit(PASS_OPAQUE, shader, *this, mtx, 0.0f);
+}
 
-	GLuint uFog = glGetUniformLocation(shaderProgram, "u_fog");
-	glUniform1i(uFog, Window::m_fog);
+void Bezier::drawBatch(Shader &shader, const DrawItem *items, int count)
+{
+	shader.use();
+	GLState::bindVertexArray(m_VAO);
 
-	GLuint uCamPos = glGetUniformLocation(shaderProgram, "u_camPos");
-	glUniform3f(uCamPos, Window::m_camPos.x, Window::m_camPos.y, Window::m_camPos.z);
+	// Every 16 control points form one patch; the TCS picks the subdivision per patch
+	if (m_tessellate)
+		glPatchParameteri(GL_PATCH_VERTICES, BEZIER_CONTROL_POINTS);
 
-	for (int i = 0; i <= 100; i++)
+	for (int i = 0; i < count; i++)
 	{
-		glBindVertexArray(m_VAO[i]);
-		glDrawArrays(GL_TRIANGLE_STRIP, 0, static_cast<GLsizei>(m_vertices[i].size()));
-		glBindVertexArray(0);
+		shader.setUniform(U_MODEL_VIEW, items[i].modelView);
+
+		if (m_tessellate)
+			glDrawArrays(GL_PATCHES, 0, static_cast<GLsizei>(m_controlPoints.size()));
+		else
+		{
+			// All patches in one call; each patch offsets the shared index list by its base vertex
+			glMultiDrawElementsBaseVertex(GL_TRIANGLES, &m_counts[0], GL_UNSIGNED_SHORT, &m_offsets[0], static_cast<GLsizei>(m_counts.size()), &m_baseVertices[0]);
+		}
 	}
 }
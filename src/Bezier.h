@@ -47,22 +47,53 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <vector>
 
-class Bezier
+#include "RenderQueue.h"
+#include "SceneGraph.h"
+#include "Shader.h"
+
+// Number of segments each patch is tessellated into along u and v (CPU fallback)
+constexpr int BEZIER_RESOLUTION = 100;
+
+// Control points per bicubic patch
+constexpr int BEZIER_CONTROL_POINTS = 16;
+
+// Set of bicubic Bezier patches sharing one vertex/index buffer.
+// With tessellation only the control points are uploaded and the GPU evaluates the surface;
+// otherwise every patch is evaluated on the CPU into a fixed-resolution grid.
+class Bezier : public Drawable
 {
 public:
-	int m_surface;
-	GLuint m_VAO[101], m_VBO[101];
+	Bezier(bool tessellate);
+	~Bezier();
+
+	static bool tessellationSupported();
 
-	Bezier(const glm::vec3 points[16]);
-	void draw(const GLuint &shaderProgram);
+	void addPatch(const glm::vec3 points[16], int surface);
+	void upload();
+	void draw(Shader &shader, const glm::mat4 &mtx);
+	void drawBatch(Shader &shader, const DrawItem *items, int count);
+
+	const Bounds &bounds() const { return m_bounds; }
 
 private:
-	glm::vec3 m_points[16];
-	glm::mat4 m_G[3];
-	glm::mat4 m_C[3];
+	struct Vertex
+	{
+		glm::vec3 pos;
+		GLint surface;		// Surface color id (1-4)
+	};
+
+	GLuint m_VAO, m_VBO, m_EBO;
 	glm::mat4 m_B;
+	bool m_tessellate;
+	Bounds m_bounds;						// Control-point hull; encloses every patch
+
+	std::vector<Vertex> m_controlPoints;	// BEZIER_CONTROL_POINTS per patch, row-major in v
 
-	std::vector<glm::vec3> m_vertices[101];
+	std::vector<Vertex> m_vertices;		// (BEZIER_RESOLUTION + 1)^2 shared vertices per patch
+	std::vector<GLushort> m_indices;	// Triangle list of one patch, reused by every patch
+	std::vector<GLsizei> m_counts;
+	std::vector<const GLvoid *> m_offsets;
+	std::vector<GLint> m_baseVertices;
 };
 
 #endif /* Bezier_h */
@@ -0,0 +1,156 @@
+/**
+ * @file This file is part of snakesGL.
+ *
+ * @section LICENSE
+ * GNU General Public License v2.0
+ *
+ * Copyright (c) 2018-2019 Rajdeep Konwar, Luke Rohrer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @section DESCRIPTION
+ * OpenGL state cache.
+ **/
+
+#include "GLState.h"
+
+// Static data members
+int GLState::m_nIssued = 0;
+int GLState::m_nElided = 0;
+
+GLuint GLState::m_program = 0;
+GLuint GLState::m_vao = 0;
+GLfloat GLState::m_lineWidth = 1.0f;
+std::unordered_map<GLenum, GLuint> GLState::m_buffers;
+
+void GLState::useProgram(GLuint program)
+{
+	if (program == m_program)
+	{
+		m_nElided++;
+		return;
+	}
+
+	glUseProgram(program);
+	m_program = program;
+	m_nIssued++;
+}
+
+void GLState::bindVertexArray(GLuint vao)
+{
+	if (vao == m_vao)
+	{
+		m_nElided++;
+		return;
+	}
+
+	glBindVertexArray(vao);
+	m_vao = vao;
+	m_nIssued++;
+}
+
+void GLState::bindBuffer(GLenum target, GLuint buffer)
+{
+	// The element array binding belongs to the bound VAO, so it is never cached
+	if (target == GL_ELEMENT_ARRAY_BUFFER)
+	{
+		glBindBuffer(target, buffer);
+		m_nIssued++;
+		return;
+	}
+
+	auto it = m_buffers.find(target);
+	if (it != m_buffers.end() && it->second == buffer)
+	{
+		m_nElided++;
+		return;
+	}
+
+	glBindBuffer(target, buffer);
+	m_buffers[target] = buffer;
+	m_nIssued++;
+}
+
+// Also binds the generic target, as GL does
+void GLState::bindBufferBase(GLenum target, GLuint index, GLuint buffer)
+{
+	glBindBufferBase(target, index, buffer);
+	m_buffers[target] = buffer;
+	m_nIssued++;
+}
+
+// Also binds the generic target, as GL does
+void GLState::bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size)
+{
+	glBindBufferRange(target, index, buffer, offset, size);
+	m_buffers[target] = buffer;
+	m_nIssued++;
+}
+
+void GLState::lineWidth(GLfloat width)
+{
+	if (width == m_lineWidth)
+	{
+		m_nElided++;
+		return;
+	}
+
+	glLineWidth(width);
+	m_lineWidth = width;
+	m_nIssued++;
+}
+
+void GLState::deleteProgram(GLuint program)
+{
+	glDeleteProgram(program);
+
+	if (program == m_program)
+		m_program = 0;
+}
+
+void GLState::deleteVertexArrays(GLsizei n, const GLuint *vaos)
+{
+	glDeleteVertexArrays(n, vaos);
+
+	for (GLsizei i = 0; i < n; i++)
+	{
+		if (vaos[i] == m_vao)
+			m_vao = 0;
+	}
+}
+
+void GLState::deleteBuffers(GLsizei n, const GLuint *buffers)
+{
+	glDeleteBuffers(n, buffers);
+
+	for (GLsizei i = 0; i < n; i++)
+	{
+		for (auto &binding : m_buffers)
+		{
+			if (binding.second == buffers[i])
+				binding.second = 0;
+		}
+	}
+}
+
+void GLState::resetCounters()
+{
+	m_nIssued = 0;
+	m_nElided = 0;
+}
@@ -0,0 +1,74 @@
+/**
+ * @file This file is part of snakesGL.
+ *
+ * @section LICENSE
+ * GNU General Public License v2.0
+ *
+ * Copyright (c) 2018-2019 Rajdeep Konwar, Luke Rohrer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @section DESCRIPTION
+ * OpenGL state cache.
+ **/
+
+#ifndef GLSTATE_H
+#define GLSTATE_H
+
+#define GLFW_INCLUDE_GLEXT
+#ifdef __APPLE__
+#define GLFW_INCLUDE_GLCOREARB
+#else
+#include <GL/glew.h>
+#endif
+#include <GLFW/glfw3.h>
+
+#include <unordered_map>
+
+// Shadows the bound program, VAO, buffers and line width so calls that would not change
+// anything never reach the driver. All binds of these must go through here to keep it in sync.
+class GLState
+{
+public:
+	static void useProgram(GLuint program);
+	static void bindVertexArray(GLuint vao);
+	static void bindBuffer(GLenum target, GLuint buffer);
+	static void bindBufferBase(GLenum target, GLuint index, GLuint buffer);
+	static void bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+	static void lineWidth(GLfloat width);
+
+	// Deleting an object that is bound resets that binding to 0
+	static void deleteProgram(GLuint program);
+	static void deleteVertexArrays(GLsizei n, const GLuint *vaos);
+	static void deleteBuffers(GLsizei n, const GLuint *buffers);
+
+	static void resetCounters();
+
+public:
+	static int m_nIssued;		// State calls forwarded to GL since resetCounters
+	static int m_nElided;		// State calls dropped as redundant since resetCounters
+
+private:
+	static GLuint m_program;
+	static GLuint m_vao;
+	static GLfloat m_lineWidth;
+	static std::unordered_map<GLenum, GLuint> m_buffers;	// target -> bound buffer (not GL_ELEMENT_ARRAY_BUFFER)
+};
+
+#endif
@@ -0,0 +1,83 @@
+/**
+ * @file This file is part of snakesGL.
+ *
+ * @section LICENSE
+ * GNU General Public License v2.0
+ *
+ * Copyright (c) 2018-2019 Rajdeep Konwar, Luke Rohrer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @section DESCRIPTION
+ * Procedural ground grid.
+ **/
+
+#include "Grid.h"
+#include "Window.h"
+
+Grid::Grid(int nTile)
+{
+	// Tiles are 2x2 cells centred on even coordinates, 17 columns wide and
+	// running from one row behind the start to the last row of the track
+	float xMin = -17.0f;
+	float xMax =  17.0f;
+	float yMin = -3.0f;
+	float yMax = 2.0f * static_cast<float>(nTile) + 1.0f;
+
+	glm::vec3 vertices[4] = {	glm::vec3(xMin, yMin, 0.0f),
+								glm::vec3(xMax, yMin, 0.0f),
+								glm::vec3(xMin, yMax, 0.0f),
+								glm::vec3(xMax, yMax, 0.0f)	};
+
+	glGenVertexArrays(1, &m_VAO);
+	glGenBuffers(1, &m_VBO);
+
+	GLState::bindVertexArray(m_VAO);
+	GLState::bindBuffer(GL_ARRAY_BUFFER, m_VBO);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (GLvoid*)0);
+
+	GLState::bindBuffer(GL_ARRAY_BUFFER, 0);
+	GLState::bindVertexArray(0);
+}
+
+Grid::~Grid()
+{
+	GLState::deleteVertexArrays(1, &m_VAO);
+	GLState::deleteBuffers(1, &m_VBO);
+}
+
+void Grid::draw(Shader &shader, const glm::mat4 &mtx)
+{
+	RenderQueue::submit(PASS_GROUND, shader, *this, mtx, 0.0f);
+}
+
+void Grid::drawBatch(Shader &shader, const DrawItem *items, int count)
+{
+	shader.use();
+	GLState::bindVertexArray(m_VAO);
+
+	for (int i = 0; i < count; i++)
+	{
+		shader.setUniform(U_MODEL_VIEW, items[i].modelView);
+		glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+	}
+}
@@ -0,0 +1,285 @@
+/**
+ * @file This file is part of snakesGL.
+ *
+ * @section LICENSE
+ * GNU General Public License v2.0
+ *
+ * Copyright (c) 2018-2019 Rajdeep Konwar, Luke Rohrer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @section DESCRIPTION
+ * GPU-driven rendering: shared mesh arena, compute culling and multi-draw indirect.
+ **/
+
+#include <algorithm>
+
+#include "IndirectRenderer.h"
+#include "StreamBuffer.h"
+
+constexpr GLuint OBJECT_BINDING = 0;
+constexpr GLuint COMMAND_BINDING = 1;
+constexpr GLuint VISIBLE_BINDING = 2;
+
+// Per-instance object id attribute (divisor 1, so it starts at the command's baseInstance)
+constexpr GLuint OBJECT_ID_LOCATION = 6;
+
+constexpr GLuint CULL_GROUP_SIZE = 64;
+
+MeshArena::MeshArena() : m_indexType(GL_UNSIGNED_INT), m_maxMeshVertices(0)
+{
+	glGenBuffers(1, &m_VBO);
+	glGenBuffers(1, &m_EBO);
+}
+
+MeshArena::~MeshArena()
+{
+	GLState::deleteBuffers(1, &m_VBO);
+	GLState::deleteBuffers(1, &m_EBO);
+}
+
+int MeshArena::add(const Geometry *geometry)
+{
+	for (size_t i = 0; i < m_geometries.size(); i++)
+	{
+		if (m_geometries[i] == geometry)
+			return static_cast<int>(i);
+	}
+
+	Mesh mesh;
+	mesh.count = static_cast<GLuint>(geometry->m_indices.size());
+	mesh.firstIndex = static_cast<GLuint>(m_indices.size());
+	mesh.baseVertex = static_cast<GLint>(m_vertices.size());
+
+	m_vertices.insert(m_vertices.end(), geometry->m_vertices.begin(), geometry->m_vertices.end());
+	m_maxMeshVertices = std::max(m_maxMeshVertices, geometry->m_vertices.size());
+	m_indices.insert(m_indices.end(), geometry->m_indices.begin(), geometry->m_indices.end());
+
+	m_geometries.push_back(geometry);
+	m_meshes.push_back(mesh);
+
+	return static_cast<int>(m_meshes.size() - 1);
+}
+
+void MeshArena::upload()
+{
+	GLState::bindBuffer(GL_ARRAY_BUFFER, m_VBO);
+	glBufferData(GL_ARRAY_BUFFER, m_vertices.size() * sizeof(MeshVertex), &m_vertices[0], GL_STATIC_DRAW);
+
+	// The element binding is VAO state, so fill it through a throwaway VAO
+	GLuint vao;
+	glGenVertexArrays(1, &vao);
+	GLState::bindVertexArray(vao);
+	GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
+	m_indexType = uploadIndices(m_indices, m_maxMeshVertices);
+	GLState::bindVertexArray(0);
+	GLState::deleteVertexArrays(1, &vao);
+}
+
+void MeshArena::bindAttributes() const
+{
+	GLState::bindBuffer(GL_ARRAY_BUFFER, m_VBO);
+	MeshVertex::setAttributes();
+
+	GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
+}
+
+IndirectRenderer::IndirectRenderer(MeshArena &arena) : m_arena(arena), m_cullShader(nullptr), m_culled(false)
+{
+	glGenVertexArrays(1, &m_VAO);
+	glGenBuffers(1, &m_objectBuffer);
+	glGenBuffers(1, &m_commandBuffer);
+	glGenBuffers(1, &m_visibleBuffer);
+}
+
+IndirectRenderer::~IndirectRenderer()
+{
+	GLState::deleteVertexArrays(1, &m_VAO);
+
+	GLState::deleteBuffers(1, &m_objectBuffer);
+	GLState::deleteBuffers(1, &m_commandBuffer);
+	GLState::deleteBuffers(1, &m_visibleBuffer);
+}
+
+bool IndirectRenderer::supported()
+{
+	GLint major = 0, minor = 0;
+	glGetIntegerv(GL_MAJOR_VERSION, &major);
+	glGetIntegerv(GL_MINOR_VERSION, &minor);
+
+	return major > 4 || (major == 4 && minor >= 3);
+}
+
+void IndirectRenderer::addObject(Transform *transform, Geometry *geometry)
+{
+	ObjectRecord object;
+	object.model = glm::mat4(1.0f);
+	object.boundsMin = glm::vec4(geometry->m_localBounds.m_min, 1.0f);
+	object.boundsMax = glm::vec4(geometry->m_localBounds.m_max, 1.0f);
+	object.mesh = static_cast<GLuint>(m_arena.add(geometry));
+	object.material = std::max(transform->m_material, 0);
+	object.destroyed = 0;
+	object.pad = 0;
+
+	transform->trackChanges(&m_changedIds, static_cast<GLuint>(m_objects.size()));
+
+	m_transforms.push_back(transform);
+	m_objects.push_back(object);
+}
+
+void IndirectRenderer::upload()
+{
+	// Each command owns a slice of the visible-id buffer big enough for all of its objects
+	std::vector<GLuint> perMesh(m_arena.m_meshes.size(), 0);
+	for (const auto &object : m_objects)
+		perMesh[object.mesh]++;
+
+	GLuint baseInstance = 0;
+	m_commands.clear();
+	for (size_t i = 0; i < m_arena.m_meshes.size(); i++)
+	{
+		DrawCommand command;
+		command.count = m_arena.m_meshes[i].count;
+		command.instanceCount = 0;
+		command.firstIndex = m_arena.m_meshes[i].firstIndex;
+		command.baseVertex = m_arena.m_meshes[i].baseVertex;
+		command.baseInstance = baseInstance;
+		m_commands.push_back(command);
+
+		baseInstance += perMesh[i];
+	}
+
+	// Object records stay resident; only changed records and the command reset go through the stream buffer
+	GLState::bindBuffer(GL_SHADER_STORAGE_BUFFER, m_objectBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, m_objects.size() * sizeof(ObjectRecord), &m_objects[0], GL_DYNAMIC_DRAW);
+
+	GLState::bindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer);
+	glBufferData(GL_DRAW_INDIRECT_BUFFER, m_commands.size() * sizeof(DrawCommand), &m_commands[0], GL_DYNAMIC_DRAW);
+
+	GLState::bindBuffer(GL_ARRAY_BUFFER, m_visibleBuffer);
+	glBufferData(GL_ARRAY_BUFFER, m_objects.size() * sizeof(GLuint), nullptr, GL_DYNAMIC_DRAW);
+
+	GLState::bindVertexArray(m_VAO);
+	m_arena.bindAttributes();
+
+	GLState::bindBuffer(GL_ARRAY_BUFFER, m_visibleBuffer);
+	glEnableVertexAttribArray(OBJECT_ID_LOCATION);
+	glVertexAttribIPointer(OBJECT_ID_LOCATION, 1, GL_UNSIGNED_INT, sizeof(GLuint), (GLvoid *)0);
+	glVertexAttribDivisor(OBJECT_ID_LOCATION, 1);
+
+	GLState::bindVertexArray(0);
+}
+
+void IndirectRenderer::draw(Shader &cullShader, Shader &shader)
+{
+	if (m_objects.empty())
+		return;
+
+	m_cullShader = &cullShader;
+	m_culled = false;
+
+	RenderQueue::submit(PASS_OPAQUE, shader, *this, glm::mat4(1.0f), 0.0f);
+}
+
+void IndirectRenderer::patchObjects()
+{
+	if (m_changedIds.empty())
+		return;
+
+	// Each record is queued once, but in the order its transform changed
+	std::sort(m_changedIds.begin(), m_changedIds.end());
+
+	// World matrices are cached by the bounds pass earlier in the frame
+	for (GLuint id : m_changedIds)
+	{
+		m_objects[id].model = m_transforms[id]->worldMatrix();
+		m_objects[id].destroyed = m_transforms[id]->m_destroyed ? 1 : 0;
+		m_transforms[id]->m_changeQueued = false;
+	}
+
+	// One copy per run of consecutive records (a snake's segments are added together)
+	for (size_t first = 0; first < m_changedIds.size();)
+	{
+		size_t last = first;
+		while (last + 1 < m_changedIds.size() && m_changedIds[last + 1] == m_changedIds[last] + 1)
+			last++;
+
+		GLuint id = m_changedIds[first];
+		GLsizeiptr size = (last - first + 1) * sizeof(ObjectRecord);
+		GLintptr offset = StreamBuffer::write(&m_objects[id], size, sizeof(glm::vec4));
+
+		GLState::bindBuffer(GL_COPY_READ_BUFFER, StreamBuffer::m_buffer);
+		GLState::bindBuffer(GL_COPY_WRITE_BUFFER, m_objectBuffer);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, offset, id * sizeof(ObjectRecord), size);
+
+		first = last + 1;
+	}
+
+	m_changedIds.clear();
+}
+
+void IndirectRenderer::cull()
+{
+	patchObjects();
+
+	// Reset every instanceCount to 0 with a GPU-side copy from the stream
+	GLsizeiptr commandsSize = m_commands.size() * sizeof(DrawCommand);
+	GLintptr commandsOffset = StreamBuffer::write(&m_commands[0], commandsSize, sizeof(GLuint));
+	GLState::bindBuffer(GL_COPY_READ_BUFFER, StreamBuffer::m_buffer);
+	GLState::bindBuffer(GL_COPY_WRITE_BUFFER, m_commandBuffer);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, commandsOffset, 0, commandsSize);
+
+	GLState::bindBufferBase(GL_SHADER_STORAGE_BUFFER, OBJECT_BINDING, m_objectBuffer);
+	GLState::bindBufferBase(GL_SHADER_STORAGE_BUFFER, COMMAND_BINDING, m_commandBuffer);
+	GLState::bindBufferBase(GL_SHADER_STORAGE_BUFFER, VISIBLE_BINDING, m_visibleBuffer);
+
+	// Cull against the same frustum (and fog distance) the scene graph uses
+	const Frustum &frustum = Transform::frustum();
+
+	m_cullShader->use();
+	glUniform4fv(m_cullShader->location("u_planes"), 6, &frustum.m_planes[0][0]);
+	glUniform3fv(m_cullShader->location("u_eye"), 1, &frustum.m_eye[0]);
+	glUniform1f(m_cullShader->location("u_maxDist"), frustum.m_maxDist);
+	glUniform1ui(m_cullShader->location("u_objectCount"), static_cast<GLuint>(m_objects.size()));
+
+	GLuint nGroups = (static_cast<GLuint>(m_objects.size()) + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE;
+	glDispatchCompute(nGroups, 1, 1);
+
+	// Commands are read by the draw, visible ids by the vertex fetch, object records by the vertex shader
+	glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+
+	m_culled = true;
+}
+
+void IndirectRenderer::drawBatch(Shader &shader, const DrawItem *items, int count)
+{
+	if (!m_culled)
+		cull();
+
+	// Another group may have culled into the shared binding since
+	GLState::bindBufferBase(GL_SHADER_STORAGE_BUFFER, OBJECT_BINDING, m_objectBuffer);
+
+	shader.use();
+	GLState::bindVertexArray(m_VAO);
+	GLState::bindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer);
+
+	// Each item is the whole set; records carry their own world matrices
+	for (int i = 0; i < count; i++)
+		glMultiDrawElementsIndirect(GL_TRIANGLES, m_arena.m_indexType, (GLvoid *)0, static_cast<GLsizei>(m_commands.size()), 0);
+}
@@ -0,0 +1,147 @@
+/**
+ * @file This file is part of snakesGL.
+ *
+ * @section LICENSE
+ * GNU General Public License v2.0
+ *
+ * Copyright (c) 2018-2019 Rajdeep Konwar, Luke Rohrer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @section DESCRIPTION
+ * GPU-driven rendering: shared mesh arena, compute culling and multi-draw indirect.
+ **/
+
+#ifndef INDIRECT_RENDERER_H
+#define INDIRECT_RENDERER_H
+
+#define GLFW_INCLUDE_GLEXT
+#ifdef __APPLE__
+#define GLFW_INCLUDE_GLCOREARB
+#else
+#include <GL/glew.h>
+#endif
+#include <GLFW/glfw3.h>
+// Use of degrees is deprecated. Use radians instead.
+#ifndef GLM_FORCE_RADIANS
+#define GLM_FORCE_RADIANS
+#endif
+#include <glm/mat4x4.hpp>
+
+#include <vector>
+
+#include "RenderQueue.h"
+#include "SceneGraph.h"
+#include "Shader.h"
+
+// Vertex/index data of every registered Geometry in one set of buffers
+class MeshArena
+{
+public:
+	struct Mesh
+	{
+		GLuint count;			// Number of indices
+		GLuint firstIndex;
+		GLint baseVertex;
+	};
+
+	MeshArena();
+	~MeshArena();
+
+	// Index of geometry's mesh in the arena (added on first use)
+	int add(const Geometry *geometry);
+	void upload();
+
+	// Point attributes 0 (position), 1 (normal) and the element buffer of the bound VAO at the arena
+	void bindAttributes() const;
+
+public:
+	std::vector<Mesh> m_meshes;
+	GLenum m_indexType;				// 16-bit while every mesh stays below 65536 vertices (indices are relative to baseVertex)
+
+private:
+	GLuint m_VBO, m_EBO;
+	std::vector<const Geometry *> m_geometries;
+	std::vector<MeshVertex> m_vertices;
+	std::vector<GLuint> m_indices;
+	size_t m_maxMeshVertices;
+};
+
+// A group of (transform, geometry) objects culled by a compute shader and drawn with
+// one glMultiDrawElementsIndirect, whatever the number of objects
+class IndirectRenderer : public Drawable
+{
+public:
+	IndirectRenderer(MeshArena &arena);
+	~IndirectRenderer();
+
+	// Compute shaders, SSBOs and multi-draw indirect are core since OpenGL 4.3
+	static bool supported();
+
+	void addObject(Transform *transform, Geometry *geometry);
+
+	// Create the GPU buffers; call after every object is added and the arena is uploaded
+	void upload();
+
+	// Submit the group to the queue; culling runs once, when the queue first draws it
+	void draw(Shader &cullShader, Shader &shader);
+	void drawBatch(Shader &shader, const DrawItem *items, int count);
+
+private:
+	void cull();
+
+	// Refresh the changed records and copy them into the resident buffer through the stream buffer
+	void patchObjects();
+
+private:
+	// Mirrors the std430 Object struct in CullShader.comp and the *IndirectShader.vert shaders
+	struct ObjectRecord
+	{
+		glm::mat4 model;
+		glm::vec4 boundsMin;
+		glm::vec4 boundsMax;
+		GLuint mesh;
+		GLint material;
+		GLuint destroyed;
+		GLuint pad;
+	};
+
+	// Layout fixed by glMultiDrawElementsIndirect
+	struct DrawCommand
+	{
+		GLuint count;
+		GLuint instanceCount;
+		GLuint firstIndex;
+		GLint baseVertex;
+		GLuint baseInstance;
+	};
+
+	MeshArena &m_arena;
+	Shader *m_cullShader;
+	bool m_culled;							// Commands hold this frame's visible set (drawn again by the depth pre-pass)
+	std::vector<Transform *> m_transforms;
+	std::vector<ObjectRecord> m_objects;
+	std::vector<DrawCommand> m_commands;		// One per arena mesh, instanceCount 0
+	std::vector<GLuint> m_changedIds;		// Records whose transform changed since the last cull (fed by Transform)
+
+	GLuint m_VAO;
+	GLuint m_objectBuffer, m_commandBuffer, m_visibleBuffer;
+};
+
+#endif
@@ -2,7 +2,7 @@
  * @file This file is part of snakesGL.
  *
  * @section LICENSE
- * MIT License
+ * GNU General Public License v2.0
  *
  * Copyright (c) 2018-2019 Rajdeep Konwar, Luke Rohrer
  *
@@ -25,35 +25,38 @@
  * SOFTWARE.
  *
  * @section DESCRIPTION
- * Grid Big Fragment Shader.
+ * Read-only memory mapping of a whole file.
  **/
 
-#version 330 core
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
 
-in vec3 FragCoord;
-in vec4 ViewSpace;
+#include <cstddef>
 
-uniform vec4 u_camPos;
-uniform bool u_fog;
+// A whole file mapped read-only into memory; unmapped on destruction
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
 
-out vec4 FragColor;
+	MappedFile(const MappedFile &) = delete;
+	MappedFile &operator=(const MappedFile &) = delete;
 
-void main()
-{
-	//! Linear fog
-	vec3 distVector = vec3(ViewSpace) - vec3(u_camPos);
-	float dist = length(distVector);
-
-	float minFogDist = 2.0f;
-	float maxFogDist = 17.0f;
-
-	float fogFactor = (maxFogDist - dist) / (maxFogDist - minFogDist);
-	vec4 fogColor = vec4(0.3f, 0.3f, 0.3f, 1.0f);
-	vec4 tileColor = vec4(0.0f, 0.0f, 0.0f, 1.0f);
-
-	fogFactor = clamp(fogFactor, 0.0f, 1.0f);
-	if (u_fog)
-		FragColor = mix(fogColor, tileColor, fogFactor);
-	else
-		FragColor = tileColor;
-}
+	// False if the file cannot be opened or mapped; an empty file maps to size 0
+	bool open(const char *fileName);
+	void close();
+
+	const char *data() const { return m_data; }
+	size_t size() const { return m_size; }
+
+private:
+	const char *m_data;
+	size_t m_size;
+
+#ifdef _WIN32
+	void *m_file, *m_mapping;
+#endif
+};
+
+#endif
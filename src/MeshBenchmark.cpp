@@ -0,0 +1,273 @@
+/**
+ * @file This file is part of snakesGL.
+ *
+ * @section LICENSE
+ * GNU General Public License v2.0
+ *
+ * Copyright (c) 2018-2019 Rajdeep Konwar, Luke Rohrer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @section DESCRIPTION
+ * Reports the vertex cache miss ratio of OBJ models before and after import optimization,
+ * and times ObjLoader against the stream parser it replaced.
+ **/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "MappedFile.h"
+#include "MeshOptimizer.h"
+#include "ObjLoader.h"
+
+// Runs per parser in --time mode; the fastest is reported
+static const int TIMING_RUNS = 5;
+
+// The stream parser Geometry::load used before ObjLoader, kept as the timing baseline: one
+// string and one istringstream per line, atof, and only the first three corners of each face
+static void streamParse(const std::string &text, std::vector<glm::vec3> &positions, std::vector<glm::vec3> &normals,
+	std::vector<uint32_t> &indices)
+{
+	std::istringstream in(text);
+
+	std::string line, next;
+	while (getline(in, line))
+	{
+		if (line[0] != 'v' && line[0] != 'f')
+			continue;
+
+		std::istringstream ss(line);
+		std::vector<std::string> tokens;
+
+		while (ss)
+		{
+			if (!getline(ss, next, ' ') || tokens.size() == 4)
+				break;
+
+			tokens.push_back(next);
+		}
+
+		// The old parser indexed tokens[3] unchecked
+		if (tokens.size() < 4)
+			continue;
+
+		if (line[0] == 'v' && line[1] == 'n')
+		{
+			float n1 = static_cast<float>(atof(tokens[1].c_str()));
+			float n2 = static_cast<float>(atof(tokens[2].c_str()));
+			float n3 = static_cast<float>(atof(tokens[3].c_str()));
+
+			float mag = sqrtf(n1 * n1 + n2 * n2 + n3 * n3);
+			normals.push_back(glm::vec3(n1 / mag, n2 / mag, n3 / mag));
+		}
+		else if (line[0] == 'v' && line[1] == ' ')
+		{
+			float x = static_cast<float>(atof(tokens[1].c_str()));
+			float y = static_cast<float>(atof(tokens[2].c_str()));
+			float z = static_cast<float>(atof(tokens[3].c_str()));
+			positions.push_back(glm::vec3(x, y, z));
+		}
+		else if (line[0] == 'f')
+		{
+			for (int i = 1; i < 4; i++)
+			{
+				size_t pos = tokens[i].find("//");
+				indices.push_back(atoi((tokens[i].substr(0, pos)).c_str()) - 1);
+			}
+		}
+	}
+}
+
+static double elapsedMs(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Print vertex and triangle counts and the ACMR before and after MeshOptimizer::optimize
+static bool reportAcmr(const char *fileName)
+{
+	ObjMesh mesh;
+	if (!ObjLoader::load(fileName, mesh))
+	{
+		std::cerr << "Error loading file " << fileName << std::endl;
+		return false;
+	}
+
+	// Same steps as Geometry::load
+	std::vector<MeshVertex> vertices;
+	std::vector<uint32_t> indices;
+	MeshOptimizer::weld(mesh, vertices, indices);
+
+	float before = MeshOptimizer::acmr(indices, vertices.size());
+	MeshOptimizer::optimize(vertices, indices, OPTIMIZE_OVERDRAW);
+	float after = MeshOptimizer::acmr(indices, vertices.size());
+
+	std::cout << fileName << ": " << vertices.size() << " vertices, " << indices.size() / 3 << " triangles, ACMR "
+		<< std::fixed << std::setprecision(3) << before << " -> " << after << std::endl;
+
+	return true;
+}
+
+// Parse the same in-memory text with both parsers, so only parsing is timed
+static bool reportParseTime(const char *fileName)
+{
+	MappedFile file;
+	if (!file.open(fileName))
+	{
+		std::cerr << "Error loading file " << fileName << std::endl;
+		return false;
+	}
+
+	std::string text(file.data(), file.size());
+	double streamMs = 0.0, loaderMs = 0.0;
+	size_t streamTriangles = 0, loaderTriangles = 0;
+
+	for (int run = 0; run < TIMING_RUNS; run++)
+	{
+		std::vector<glm::vec3> positions, normals;
+		std::vector<uint32_t> indices;
+
+		auto start = std::chrono::steady_clock::now();
+		streamParse(text, positions, normals, indices);
+		double ms = elapsedMs(start);
+
+		streamMs = run ? std::min(streamMs, ms) : ms;
+		streamTriangles = indices.size() / 3;
+	}
+
+	for (int run = 0; run < TIMING_RUNS; run++)
+	{
+		ObjMesh mesh;
+
+		auto start = std::chrono::steady_clock::now();
+		bool ok = ObjLoader::parse(text.data(), text.data() + text.size(), mesh);
+		double ms = elapsedMs(start);
+
+		if (!ok)
+		{
+			std::cerr << "Error parsing file " << fileName << std::endl;
+			return false;
+		}
+
+		loaderMs = run ? std::min(loaderMs, ms) : ms;
+		loaderTriangles = mesh.m_corners.size() / 3;
+	}
+
+	std::cout << fileName << ": " << text.size() / 1024 << " KB, stream parser " << std::fixed << std::setprecision(2)
+		<< streamMs << " ms (" << streamTriangles << " triangles), ObjLoader " << loaderMs << " ms ("
+		<< loaderTriangles << " triangles), " << std::setprecision(1) << streamMs / loaderMs << "x" << std::endl;
+
+	return true;
+}
+
+// Write a UV sphere of segments x segments vertices as v//vn triangles, or as v/vt/vn quads
+static bool writeSphere(const char *fileName, int segments, bool quads)
+{
+	std::ofstream out(fileName);
+	if (!out.is_open())
+	{
+		std::cerr << "Error writing file " << fileName << std::endl;
+		return false;
+	}
+
+	const float pi = 3.14159265358979f;
+	out << std::setprecision(6) << std::fixed;
+
+	for (int r = 0; r < segments; r++)
+	{
+		float theta = pi * r / (segments - 1);
+		for (int s = 0; s < segments; s++)
+		{
+			float phi = 2.0f * pi * s / segments;
+			glm::vec3 n(sinf(theta) * cosf(phi), cosf(theta), sinf(theta) * sinf(phi));
+
+			out << "v " << n.x << " " << n.y << " " << n.z << "\n";
+			out << "vn " << n.x << " " << n.y << " " << n.z << "\n";
+			if (quads)
+				out << "vt " << static_cast<float>(s) / segments << " " << static_cast<float>(r) / (segments - 1) << "\n";
+		}
+	}
+
+	// Position, texture coordinate and normal indices are all the vertex index
+	for (int r = 0; r + 1 < segments; r++)
+	{
+		for (int s = 0; s < segments; s++)
+		{
+			int a = r * segments + s + 1;
+			int b = r * segments + (s + 1) % segments + 1;
+			int c = a + segments, d = b + segments;
+
+			if (quads)
+				out << "f " << a << "/" << a << "/" << a << " " << c << "/" << c << "/" << c << " "
+					<< d << "/" << d << "/" << d << " " << b << "/" << b << "/" << b << "\n";
+			else
+				out << "f " << a << "//" << a << " " << c << "//" << c << " " << d << "//" << d << "\n"
+					<< "f " << a << "//" << a << " " << d << "//" << d << " " << b << "//" << b << "\n";
+		}
+	}
+
+	return out.good();
+}
+
+// Usage: meshBenchmark model.obj...			ACMR before and after import optimization
+//        meshBenchmark --time model.obj...		parse time of ObjLoader and the old stream parser
+//        meshBenchmark --sphere N out.obj [quads]	write an N x N vertex UV sphere to time with
+int main(int argc, char **argv)
+{
+	if (argc >= 4 && !strcmp(argv[1], "--sphere"))
+	{
+		int segments = atoi(argv[2]);
+		if (segments < 3)
+		{
+			std::cerr << "A sphere needs at least 3 segments" << std::endl;
+			return EXIT_FAILURE;
+		}
+
+		bool quads = argc >= 5 && !strcmp(argv[4], "quads");
+		return writeSphere(argv[3], segments, quads) ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	bool timing = argc >= 2 && !strcmp(argv[1], "--time");
+	int first = timing ? 2 : 1;
+
+	if (argc <= first)
+	{
+		std::cerr << "Usage: " << argv[0] << " [--time] model.obj..." << std::endl
+			<< "       " << argv[0] << " --sphere N out.obj [quads]" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	int status = EXIT_SUCCESS;
+	for (int i = first; i < argc; i++)
+	{
+		bool ok = timing ? reportParseTime(argv[i]) : reportAcmr(argv[i]);
+		if (!ok)
+			status = EXIT_FAILURE;
+	}
+
+	return status;
+}
@@ -0,0 +1,108 @@
+/**
+ * @file This file is part of snakesGL.
+ *
+ * @section LICENSE
+ * GNU General Public License v2.0
+ *
+ * Copyright (c) 2018-2019 Rajdeep Konwar, Luke Rohrer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @section DESCRIPTION
+ * Reference-counted cache of loaded meshes.
+ **/
+
+#include "MeshCache.h"
+
+// Static data members
+std::map<std::string, MeshCache::Entry> MeshCache::m_entries;
+
+Geometry *MeshCache::acquire(const std::string &path, bool keepCpuData)
+{
+	auto it = m_entries.find(path);
+	if (it == m_entries.end())
+	{
+		Entry entry;
+		entry.geometry = new Geometry(path.c_str(), keepCpuData);
+		entry.refs = 0;
+		entry.cpuRefs = 0;
+		it = m_entries.insert(std::make_pair(path, entry)).first;
+	}
+
+	Entry &entry = it->second;
+	entry.refs++;
+
+	if (keepCpuData)
+	{
+		// A later holder may need the copy an earlier one let go of
+		entry.geometry->loadCpuData();
+		entry.cpuRefs++;
+	}
+
+	return entry.geometry;
+}
+
+void MeshCache::release(Geometry *geometry)
+{
+	auto it = find(geometry);
+	if (it == m_entries.end())
+		return;
+
+	if (--it->second.refs == 0)
+	{
+		delete it->second.geometry;
+		m_entries.erase(it);
+	}
+}
+
+void MeshCache::releaseCpuData(Geometry *geometry)
+{
+	auto it = find(geometry);
+	if (it == m_entries.end() || it->second.cpuRefs == 0)
+		return;
+
+	if (--it->second.cpuRefs == 0)
+		it->second.geometry->releaseCpuData();
+}
+
+void MeshCache::report(std::ostream &out)
+{
+	size_t gpuTotal = 0, cpuTotal = 0;
+	for (const auto &it : m_entries)
+	{
+		const Geometry *geometry = it.second.geometry;
+		out << it.first << ": " << it.second.refs << " refs, " << geometry->gpuBytes() << " bytes GPU, " << geometry->cpuBytes() << " bytes CPU" << std::endl;
+
+		gpuTotal += geometry->gpuBytes();
+		cpuTotal += geometry->cpuBytes();
+	}
+
+	out << m_entries.size() << " meshes: " << gpuTotal << " bytes GPU, " << cpuTotal << " bytes CPU" << std::endl;
+}
+
+std::map<std::string, MeshCache::Entry>::iterator MeshCache::find(const Geometry *geometry)
+{
+	for (auto it = m_entries.begin(); it != m_entries.end(); ++it)
+	{
+		if (it->second.geometry == geometry)
+			return it;
+	}
+
+	return m_entries.end();
+}
@@ -0,0 +1,70 @@
+/**
+ * @file This file is part of snakesGL.
+ *
+ * @section LICENSE
+ * GNU General Public License v2.0
+ *
+ * Copyright (c) 2018-2019 Rajdeep Konwar, Luke Rohrer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @section DESCRIPTION
+ * Reference-counted cache of loaded meshes.
+ **/
+
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include <map>
+#include <ostream>
+#include <string>
+
+#include "SceneGraph.h"
+
+// Loaded Geometry shared by path. Every acquire is paired with a release; the mesh is deleted
+// with its last reference. CPU copies of the vertices and indices are freed as soon as they are
+// uploaded, unless a subsystem that reads them (the mesh arena, collision) asks to keep them.
+class MeshCache
+{
+public:
+	// keepCpuData holds the CPU copy until the matching releaseCpuData
+	static Geometry *acquire(const std::string &path, bool keepCpuData = false);
+	static void release(Geometry *geometry);
+
+	// Frees the CPU copy once no other holder needs it
+	static void releaseCpuData(Geometry *geometry);
+
+	// References and resident GPU/CPU bytes of every loaded mesh
+	static void report(std::ostream &out);
+
+private:
+	struct Entry
+	{
+		Geometry *geometry;
+		int refs;
+		int cpuRefs;			// Holders of the CPU copy
+	};
+
+	static std::map<std::string, Entry>::iterator find(const Geometry *geometry);
+
+private:
+	static std::map<std::string, Entry> m_entries;
+};
+
+#endif
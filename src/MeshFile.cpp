@@ -0,0 +1,205 @@
+/**
+ * @file This file is part of snakesGL.
+ *
+ * @section LICENSE
+ * GNU General Public License v2.0
+ *
+ * Copyright (c) 2018-2019 Rajdeep Konwar, Luke Rohrer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @section DESCRIPTION
+ * Binary cache of imported meshes.
+ **/
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#ifdef _WIN32
+#include <direct.h>
+#include <process.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "MeshFile.h"
+#include "MeshOptimizer.h"
+
+static const char *MESH_CACHE_DIR = "./cache";
+static const char MESH_FILE_MAGIC[4] = { 'S', 'G', 'M', 'H' };
+static const uint32_t MESH_FILE_VERSION = 4;
+
+// 64-bit FNV-1a, a word at a time so hashing stays well below the cost of parsing
+static uint64_t contentHash(const char *data, size_t size)
+{
+	uint64_t hash = 14695981039346656037ULL;
+
+	size_t i = 0;
+	for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+	{
+		uint64_t word;
+		memcpy(&word, data + i, sizeof(word));
+		hash ^= word;
+		hash *= 1099511628211ULL;
+	}
+
+	for (; i < size; i++)
+	{
+		hash ^= static_cast<unsigned char>(data[i]);
+		hash *= 1099511628211ULL;
+	}
+
+	// Size too, so trailing zero bytes are not lost
+	hash ^= static_cast<uint64_t>(size);
+	hash *= 1099511628211ULL;
+
+	return hash;
+}
+
+// One cache file per source path
+static std::string meshCachePath(const std::string &objFile)
+{
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.mesh", static_cast<unsigned long long>(contentHash(objFile.c_str(), objFile.size())));
+
+	return std::string(MESH_CACHE_DIR) + "/" + name;
+}
+
+static size_t indexSize(GLenum indexType)
+{
+	return indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+}
+
+MeshFile::MeshFile() : m_sourceHash(0) {}
+
+bool MeshFile::open(const char *objFile)
+{
+	m_objFile = objFile;
+	m_file.close();
+
+	MappedFile source;
+	if (!source.open(objFile))
+		return false;
+	m_sourceHash = contentHash(source.data(), source.size());
+
+	if (!m_file.open(meshCachePath(m_objFile).c_str()))
+		return false;
+
+	// Anything truncated, stale, from another version or imported with other options is a miss
+	bool valid = m_file.size() >= sizeof(MeshFileHeader);
+	if (valid)
+	{
+		const MeshFileHeader &cached = header();
+		valid = !memcmp(cached.magic, MESH_FILE_MAGIC, sizeof(cached.magic)) &&
+			cached.version == MESH_FILE_VERSION && cached.sourceHash == m_sourceHash &&
+			cached.vertexCacheSize == VERTEX_CACHE_SIZE && cached.overdraw == (OPTIMIZE_OVERDRAW ? 1u : 0u) &&
+			(cached.indexType == GL_UNSIGNED_SHORT || cached.indexType == GL_UNSIGNED_INT) &&
+			m_file.size() == sizeof(MeshFileHeader) + cached.vertexCount * sizeof(MeshVertex) + indexBytes();
+	}
+
+	if (!valid)
+		m_file.close();
+
+	return valid;
+}
+
+void MeshFile::write(const std::vector<MeshVertex> &vertices, const std::vector<GLuint> &indices, const Bounds &bounds) const
+{
+	MeshFileHeader header;
+	memcpy(header.magic, MESH_FILE_MAGIC, sizeof(header.magic));
+	header.version = MESH_FILE_VERSION;
+	header.sourceHash = m_sourceHash;
+	header.vertexCount = static_cast<uint32_t>(vertices.size());
+	header.indexCount = static_cast<uint32_t>(indices.size());
+	header.indexType = indexType(vertices.size());
+	header.vertexCacheSize = VERTEX_CACHE_SIZE;
+	header.overdraw = OPTIMIZE_OVERDRAW ? 1 : 0;
+	header.pad = 0;
+	for (int i = 0; i < 3; i++)
+	{
+		header.boundsMin[i] = bounds.m_min[i];
+		header.boundsMax[i] = bounds.m_max[i];
+	}
+
+#ifdef _WIN32
+	_mkdir(MESH_CACHE_DIR);
+	int pid = _getpid();
+#else
+	mkdir(MESH_CACHE_DIR, 0755);
+	int pid = static_cast<int>(getpid());
+#endif
+
+	// Written under a private name and renamed into place, so instances launched together
+	// never map a half-written file
+	std::string path = meshCachePath(m_objFile);
+	std::string tmpPath = path + "." + std::to_string(pid);
+	{
+		std::ofstream file(tmpPath.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+			return;
+
+		file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char *>(vertices.data()), vertices.size() * sizeof(MeshVertex));
+
+		if (header.indexType == GL_UNSIGNED_SHORT)
+		{
+			std::vector<GLushort> shortIndices(indices.begin(), indices.end());
+			file.write(reinterpret_cast<const char *>(shortIndices.data()), shortIndices.size() * sizeof(GLushort));
+		}
+		else
+			file.write(reinterpret_cast<const char *>(indices.data()), indices.size() * sizeof(GLuint));
+
+		if (!file)
+		{
+			file.close();
+			remove(tmpPath.c_str());
+			return;
+		}
+	}
+
+	// rename does not replace an existing file on Windows
+	if (rename(tmpPath.c_str(), path.c_str()) != 0)
+	{
+		remove(path.c_str());
+		if (rename(tmpPath.c_str(), path.c_str()) != 0)
+			remove(tmpPath.c_str());
+	}
+}
+
+const MeshFileHeader &MeshFile::header() const
+{
+	return *reinterpret_cast<const MeshFileHeader *>(m_file.data());
+}
+
+const MeshVertex *MeshFile::vertices() const
+{
+	return reinterpret_cast<const MeshVertex *>(m_file.data() + sizeof(MeshFileHeader));
+}
+
+const void *MeshFile::indices() const
+{
+	return m_file.data() + sizeof(MeshFileHeader) + header().vertexCount * sizeof(MeshVertex);
+}
+
+GLsizeiptr MeshFile::indexBytes() const
+{
+	return static_cast<GLsizeiptr>(header().indexCount * indexSize(header().indexType));
+}
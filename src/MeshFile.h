@@ -0,0 +1,83 @@
+/**
+ * @file This file is part of snakesGL.
+ *
+ * @section LICENSE
+ * GNU General Public License v2.0
+ *
+ * Copyright (c) 2018-2019 Rajdeep Konwar, Luke Rohrer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @section DESCRIPTION
+ * Binary cache of imported meshes.
+ **/
+
+#ifndef MESH_FILE_H
+#define MESH_FILE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+#include "SceneGraph.h"
+
+// Start of a cached mesh file; the MeshVertex block follows, then the index block
+struct MeshFileHeader
+{
+	char magic[4];
+	uint32_t version;
+	uint64_t sourceHash;		// Content hash of the .obj it was imported from
+	uint32_t vertexCount;
+	uint32_t indexCount;
+	GLenum indexType;			// GL_UNSIGNED_SHORT or GL_UNSIGNED_INT, as uploaded
+	uint32_t vertexCacheSize;	// Import options the mesh was optimized with (MeshOptimizer.h)
+	uint32_t overdraw;
+	uint32_t pad;
+	float boundsMin[3];
+	float boundsMax[3];
+};
+
+// An imported .obj stored in GPU-ready form under ./cache, so later launches map it and hand
+// its blocks to glBufferData without parsing. A changed .obj, or different import options, no
+// longer match the header and the mesh is imported again.
+class MeshFile
+{
+public:
+	MeshFile();
+
+	// Map the cached mesh of objFile; false on a miss, if objFile changed since it was cached or
+	// if it was optimized with other options than the current ones
+	bool open(const char *objFile);
+
+	// Cache a mesh imported from the objFile given to the last open()
+	void write(const std::vector<MeshVertex> &vertices, const std::vector<GLuint> &indices, const Bounds &bounds) const;
+
+	const MeshFileHeader &header() const;
+	const MeshVertex *vertices() const;
+	const void *indices() const;
+	GLsizeiptr indexBytes() const;
+
+private:
+	std::string m_objFile;
+	uint64_t m_sourceHash;
+	MappedFile m_file;
+};
+
+#endif
@@ -0,0 +1,348 @@
+/**
+ * @file This file is part of snakesGL.
+ *
+ * @section LICENSE
+ * GNU General Public License v2.0
+ *
+ * Copyright (c) 2018-2019 Rajdeep Konwar, Luke Rohrer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @section DESCRIPTION
+ * Import-time vertex cache, overdraw and vertex fetch optimization.
+ **/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+
+#include <glm/geometric.hpp>
+
+#include "MeshOptimizer.h"
+
+// Welding compares whole packed vertices
+struct MeshVertexHash
+{
+	size_t operator()(const MeshVertex &vertex) const
+	{
+		uint32_t words[4];
+		memcpy(words, &vertex, sizeof(words));
+
+		uint64_t hash = 14695981039346656037ULL;
+		for (uint32_t word : words)
+		{
+			hash ^= word;
+			hash *= 1099511628211ULL;
+		}
+
+		return static_cast<size_t>(hash);
+	}
+};
+
+struct MeshVertexEqual
+{
+	bool operator()(const MeshVertex &a, const MeshVertex &b) const
+	{
+		return memcmp(&a, &b, sizeof(MeshVertex)) == 0;
+	}
+};
+
+static glm::vec3 unitNormal(const glm::vec3 &normal)
+{
+	float length = glm::length(normal);
+	return length > 0.0f ? normal / length : glm::vec3(0.0f);
+}
+
+// With the rest of the import, so tools that only import meshes build without GL
+uint32_t MeshVertex::packNormal(const glm::vec3 &normal)
+{
+	uint32_t packed = 0;
+	for (int i = 0; i < 3; i++)
+	{
+		float c = std::min(std::max(normal[i], -1.0f), 1.0f);
+		int32_t value = static_cast<int32_t>(std::floor(c * 511.0f + 0.5f));
+		packed |= (static_cast<uint32_t>(value) & 0x3FFu) << (10 * i);
+	}
+
+	return packed;
+}
+
+void MeshOptimizer::weld(const ObjMesh &mesh, std::vector<MeshVertex> &vertices, std::vector<uint32_t> &indices)
+{
+	// Corners without a normal get the area-weighted average of the faces around their position
+	std::vector<glm::vec3> faceNormals;
+	for (size_t i = 0; i + 2 < mesh.m_corners.size(); i += 3)
+	{
+		const ObjCorner *corner = &mesh.m_corners[i];
+		if (corner[0].m_normal >= 0 && corner[1].m_normal >= 0 && corner[2].m_normal >= 0)
+			continue;
+
+		if (faceNormals.empty())
+			faceNormals.resize(mesh.m_positions.size(), glm::vec3(0.0f));
+
+		const glm::vec3 &p0 = mesh.m_positions[corner[0].m_position];
+		glm::vec3 normal = glm::cross(mesh.m_positions[corner[1].m_position] - p0, mesh.m_positions[corner[2].m_position] - p0);
+		for (int k = 0; k < 3; k++)
+			faceNormals[corner[k].m_position] += normal;
+	}
+
+	// Weld corners into unique (position, normal) vertices; corners that pack to the same
+	// vertex share it even if the file lists them under different indices
+	std::unordered_map<MeshVertex, uint32_t, MeshVertexHash, MeshVertexEqual> welded;
+	welded.reserve(mesh.m_corners.size());
+
+	vertices.clear();
+	indices.resize(mesh.m_corners.size());
+	for (size_t i = 0; i < mesh.m_corners.size(); i++)
+	{
+		const ObjCorner &corner = mesh.m_corners[i];
+
+		MeshVertex vertex;
+		vertex.m_position = mesh.m_positions[corner.m_position];
+		if (corner.m_normal >= 0)
+			vertex.m_normal = MeshVertex::packNormal(unitNormal(mesh.m_normals[corner.m_normal]));
+		else
+			vertex.m_normal = MeshVertex::packNormal(unitNormal(faceNormals[corner.m_position]));
+
+		auto found = welded.insert(std::make_pair(vertex, static_cast<uint32_t>(vertices.size())));
+		if (found.second)
+			vertices.push_back(vertex);
+
+		// Populate face-indices
+		indices[i] = found.first->second;
+	}
+}
+
+void MeshOptimizer::optimize(std::vector<MeshVertex> &vertices, std::vector<uint32_t> &indices, bool overdraw)
+{
+	if (indices.size() < 3)
+		return;
+
+	std::vector<size_t> clusters;
+	tipsify(indices, vertices.size(), VERTEX_CACHE_SIZE, clusters);
+
+	if (overdraw)
+		sortClusters(vertices, indices, clusters);
+
+	optimizeFetch(vertices, indices);
+}
+
+float MeshOptimizer::acmr(const std::vector<uint32_t> &indices, size_t nVertices, unsigned cacheSize)
+{
+	if (indices.size() < 3)
+		return 0.0f;
+
+	// A vertex stays cached until cacheSize more misses have pushed it out (0: never loaded)
+	std::vector<size_t> loadedAt(nVertices, 0);
+	size_t misses = 0;
+	for (uint32_t index : indices)
+	{
+		if (loadedAt[index] == 0 || misses - loadedAt[index] >= cacheSize)
+		{
+			misses++;
+			loadedAt[index] = misses;
+		}
+	}
+
+	return static_cast<float>(misses) / static_cast<float>(indices.size() / 3);
+}
+
+void MeshOptimizer::tipsify(std::vector<uint32_t> &indices, size_t nVertices, unsigned cacheSize, std::vector<size_t> &clusters)
+{
+	size_t nTriangles = indices.size() / 3;
+
+	// Triangles around each vertex, and how many of them are still to be emitted
+	std::vector<unsigned> live(nVertices, 0), offsets(nVertices + 1, 0);
+	for (uint32_t index : indices)
+		live[index]++;
+	for (size_t v = 0; v < nVertices; v++)
+		offsets[v + 1] = offsets[v] + live[v];
+
+	std::vector<unsigned> adjacency(indices.size()), fill(offsets.begin(), offsets.end() - 1);
+	for (size_t t = 0; t < nTriangles; t++)
+	{
+		for (int k = 0; k < 3; k++)
+			adjacency[fill[indices[3 * t + k]]++] = static_cast<unsigned>(t);
+	}
+
+	// Time each vertex last entered the simulated cache
+	std::vector<unsigned> timestamps(nVertices, 0);
+	unsigned time = cacheSize + 1;
+
+	std::vector<bool> emitted(nTriangles, false);
+	std::vector<uint32_t> output, deadEnds, candidates;
+	output.reserve(indices.size());
+
+	clusters.clear();
+	size_t cursor = 0;
+	while (cursor < nVertices && live[cursor] == 0)
+		cursor++;
+
+	long fanning = cursor < nVertices ? static_cast<long>(cursor) : -1;
+	bool restart = true;
+
+	while (fanning >= 0)
+	{
+		// Every jump to a vertex outside the cache starts a new cluster
+		if (restart)
+			clusters.push_back(output.size() / 3);
+
+		// Emit the remaining triangles around the fanning vertex
+		candidates.clear();
+		for (unsigned a = offsets[fanning]; a < offsets[fanning + 1]; a++)
+		{
+			unsigned t = adjacency[a];
+			if (emitted[t])
+				continue;
+
+			for (int k = 0; k < 3; k++)
+			{
+				uint32_t v = indices[3 * t + k];
+				output.push_back(v);
+				deadEnds.push_back(v);
+				candidates.push_back(v);
+				live[v]--;
+
+				if (time - timestamps[v] > cacheSize)
+					timestamps[v] = time++;
+			}
+
+			emitted[t] = true;
+		}
+
+		// Next fanning vertex: the oldest candidate that stays cached while its fan is emitted
+		long next = -1;
+		long bestPriority = -1;
+		for (uint32_t v : candidates)
+		{
+			if (live[v] == 0)
+				continue;
+
+			long priority = 0;
+			if (time - timestamps[v] + 2 * live[v] <= cacheSize)
+				priority = time - timestamps[v];
+
+			if (priority > bestPriority)
+			{
+				bestPriority = priority;
+				next = v;
+			}
+		}
+
+		restart = next < 0;
+		if (restart)
+		{
+			// Dead end: back up to a recently used vertex, else the next one in index order
+			while (!deadEnds.empty() && next < 0)
+			{
+				uint32_t v = deadEnds.back();
+				deadEnds.pop_back();
+				if (live[v] > 0)
+					next = v;
+			}
+
+			while (next < 0 && cursor < nVertices)
+			{
+				if (live[cursor] > 0)
+					next = static_cast<long>(cursor);
+				else
+					cursor++;
+			}
+		}
+
+		fanning = next;
+	}
+
+	clusters.push_back(nTriangles);
+	indices.swap(output);
+}
+
+void MeshOptimizer::sortClusters(const std::vector<MeshVertex> &vertices, std::vector<uint32_t> &indices, const std::vector<size_t> &clusters)
+{
+	glm::vec3 meshCentroid(0.0f);
+	for (const auto &vertex : vertices)
+		meshCentroid += vertex.m_position;
+	meshCentroid = meshCentroid / static_cast<float>(vertices.size());
+
+	// How far each cluster faces away from the centre of the mesh
+	size_t nClusters = clusters.size() - 1;
+	std::vector<float> outwardness(nClusters);
+	for (size_t c = 0; c < nClusters; c++)
+	{
+		glm::vec3 centroid(0.0f), normal(0.0f);
+		float area = 0.0f;
+
+		for (size_t t = clusters[c]; t < clusters[c + 1]; t++)
+		{
+			const glm::vec3 &p0 = vertices[indices[3 * t]].m_position;
+			const glm::vec3 &p1 = vertices[indices[3 * t + 1]].m_position;
+			const glm::vec3 &p2 = vertices[indices[3 * t + 2]].m_position;
+
+			// Area-weighted: the cross product's length is twice the triangle's area
+			glm::vec3 faceNormal = glm::cross(p1 - p0, p2 - p0);
+			float faceArea = glm::length(faceNormal);
+
+			normal += faceNormal;
+			centroid += (p0 + p1 + p2) * (faceArea / 3.0f);
+			area += faceArea;
+		}
+
+		float normalLength = glm::length(normal);
+		if (area > 0.0f && normalLength > 0.0f)
+			outwardness[c] = glm::dot(centroid / area - meshCentroid, normal / normalLength);
+		else
+			outwardness[c] = 0.0f;
+	}
+
+	std::vector<size_t> order(nClusters);
+	for (size_t c = 0; c < nClusters; c++)
+		order[c] = c;
+	std::stable_sort(order.begin(), order.end(), [&outwardness](size_t a, size_t b) { return outwardness[a] > outwardness[b]; });
+
+	std::vector<uint32_t> sorted;
+	sorted.reserve(indices.size());
+	for (size_t c : order)
+		sorted.insert(sorted.end(), indices.begin() + 3 * clusters[c], indices.begin() + 3 * clusters[c + 1]);
+
+	indices.swap(sorted);
+}
+
+void MeshOptimizer::optimizeFetch(std::vector<MeshVertex> &vertices, std::vector<uint32_t> &indices)
+{
+	// Number vertices in the order the triangles first use them; unused ones are dropped
+	const uint32_t unused = ~0u;
+	std::vector<uint32_t> remap(vertices.size(), unused);
+	std::vector<MeshVertex> reordered;
+	reordered.reserve(vertices.size());
+
+	for (uint32_t &index : indices)
+	{
+		if (remap[index] == unused)
+		{
+			remap[index] = static_cast<uint32_t>(reordered.size());
+			reordered.push_back(vertices[index]);
+		}
+
+		index = remap[index];
+	}
+
+	vertices.swap(reordered);
+}
@@ -0,0 +1,71 @@
+/**
+ * @file This file is part of snakesGL.
+ *
+ * @section LICENSE
+ * GNU General Public License v2.0
+ *
+ * Copyright (c) 2018-2019 Rajdeep Konwar, Luke Rohrer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @section DESCRIPTION
+ * Import-time vertex cache, overdraw and vertex fetch optimization.
+ **/
+
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include <cstdint>
+#include <vector>
+
+#include "MeshVertex.h"
+#include "ObjLoader.h"
+
+// Post-transform vertex cache size assumed when ordering triangles and measuring ACMR
+constexpr unsigned VERTEX_CACHE_SIZE = 16;
+
+// Sort triangle clusters of imported meshes outward-facing first
+constexpr bool OPTIMIZE_OVERDRAW = true;
+
+// Builds the indexed triangle list of an OBJ mesh, then reorders its triangles and vertices
+// for the GPU: Tipsify
+// (Sander, Nehab and Barczak 2007) for vertex cache locality, optionally followed by its
+// overdraw pass, then vertices renumbered in the order they are first fetched
+class MeshOptimizer
+{
+public:
+	// Weld corners into unique (position, normal) vertices; corners without a normal get a generated one
+	static void weld(const ObjMesh &mesh, std::vector<MeshVertex> &vertices, std::vector<uint32_t> &indices);
+
+	static void optimize(std::vector<MeshVertex> &vertices, std::vector<uint32_t> &indices, bool overdraw);
+
+	// Average cache miss ratio: transformed vertices per triangle with a FIFO cache (0.5 is ideal, 3 the worst)
+	static float acmr(const std::vector<uint32_t> &indices, size_t nVertices, unsigned cacheSize = VERTEX_CACHE_SIZE);
+
+private:
+	// Tipsify; clusters receives the first triangle of each cluster (a cache restart) plus the count
+	static void tipsify(std::vector<uint32_t> &indices, size_t nVertices, unsigned cacheSize, std::vector<size_t> &clusters);
+
+	// Put outward-facing clusters first, so they tend to occlude the rest of the mesh
+	static void sortClusters(const std::vector<MeshVertex> &vertices, std::vector<uint32_t> &indices, const std::vector<size_t> &clusters);
+
+	static void optimizeFetch(std::vector<MeshVertex> &vertices, std::vector<uint32_t> &indices);
+};
+
+#endif
@@ -0,0 +1,298 @@
+/**
+ * @file This file is part of snakesGL.
+ *
+ * @section LICENSE
+ * GNU General Public License v2.0
+ *
+ * Copyright (c) 2018-2019 Rajdeep Konwar, Luke Rohrer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @section DESCRIPTION
+ * Single-pass Wavefront OBJ parser.
+ **/
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include "MappedFile.h"
+#include "ObjLoader.h"
+
+// Powers of ten that are exact as doubles; mantissa * or / these rounds correctly
+static const double POWERS_OF_10[] =
+{
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// Digits beyond this many cannot change a float
+static const int MAX_MANTISSA_DIGITS = 19;
+
+static inline bool isBlank(char c)
+{
+	return c == ' ' || c == '\t';
+}
+
+static inline bool isDigit(char c)
+{
+	return c >= '0' && c <= '9';
+}
+
+static inline const char *skipBlanks(const char *p, const char *end)
+{
+	while (p < end && isBlank(*p))
+		p++;
+
+	return p;
+}
+
+static inline const char *skipLine(const char *p, const char *end)
+{
+	const char *newline = static_cast<const char *>(memchr(p, '\n', end - p));
+	return newline ? newline + 1 : end;
+}
+
+// Resolve a 1-based OBJ index, or a negative one relative to the count so far, to 0-based
+static inline bool resolveIndex(int index, size_t count, int &resolved)
+{
+	if (index > 0)
+		resolved = index - 1;
+	else if (index < 0)
+		resolved = static_cast<int>(count) + index;
+	else
+		return false;
+
+	return resolved >= 0 && static_cast<size_t>(resolved) < count;
+}
+
+bool ObjLoader::load(const char *fileName, ObjMesh &mesh)
+{
+	MappedFile file;
+	if (!file.open(fileName))
+		return false;
+
+	return parse(file.data(), file.data() + file.size(), mesh);
+}
+
+bool ObjLoader::parse(const char *begin, const char *end, ObjMesh &mesh)
+{
+	mesh.m_positions.clear();
+	mesh.m_normals.clear();
+	mesh.m_corners.clear();
+
+	// Skip a UTF-8 byte order mark
+	const char *p = begin;
+	if (end - p >= 3 && memcmp(p, "\xEF\xBB\xBF", 3) == 0)
+		p += 3;
+
+	while (p < end)
+	{
+		p = skipBlanks(p, end);
+		if (p == end)
+			break;
+
+		bool isNormal = end - p > 2 && p[0] == 'v' && p[1] == 'n' && isBlank(p[2]);
+		bool isPosition = end - p > 1 && p[0] == 'v' && isBlank(p[1]);
+
+		// vertices and normals; a trailing w is ignored
+		if (isNormal || isPosition)
+		{
+			p += isNormal ? 2 : 1;
+
+			glm::vec3 value;
+			for (int i = 0; i < 3; i++)
+			{
+				p = parseFloat(skipBlanks(p, end), end, value[i]);
+				if (!p)
+					return false;
+			}
+
+			if (isNormal)
+				mesh.m_normals.push_back(value);
+			else
+				mesh.m_positions.push_back(value);
+		}
+
+		// faces, fanned from their first corner
+		else if (end - p > 1 && p[0] == 'f' && isBlank(p[1]))
+		{
+			p++;
+
+			ObjCorner first = {}, previous = {};
+			int nCorners = 0;
+			while (true)
+			{
+				p = skipBlanks(p, end);
+				if (p == end || *p == '\n' || *p == '\r' || *p == '#')
+					break;
+
+				ObjCorner corner;
+				bool ok;
+				p = parseCorner(p, end, mesh, corner, ok);
+				if (!ok)
+					return false;
+
+				if (nCorners == 0)
+					first = corner;
+				else if (nCorners >= 2)
+				{
+					mesh.m_corners.push_back(first);
+					mesh.m_corners.push_back(previous);
+					mesh.m_corners.push_back(corner);
+				}
+
+				previous = corner;
+				nCorners++;
+			}
+
+			if (nCorners < 3)
+				return false;
+		}
+
+		p = skipLine(p, end);
+	}
+
+	return true;
+}
+
+const char *ObjLoader::parseFloat(const char *p, const char *end, float &value)
+{
+	const char *start = p;
+
+	bool negative = false;
+	if (p < end && (*p == '-' || *p == '+'))
+		negative = *p++ == '-';
+
+	// Up to 19 significant digits fit in 64 bits; the rest only shift the exponent
+	uint64_t mantissa = 0;
+	int exponent = 0, nDigits = 0;
+	bool found = false;
+
+	for (; p < end && isDigit(*p); p++, found = true)
+	{
+		if (nDigits < MAX_MANTISSA_DIGITS)
+		{
+			mantissa = mantissa * 10 + (*p - '0');
+			if (mantissa)
+				nDigits++;
+		}
+		else
+			exponent++;
+	}
+
+	if (p < end && *p == '.')
+	{
+		for (p++; p < end && isDigit(*p); p++, found = true)
+		{
+			if (nDigits < MAX_MANTISSA_DIGITS)
+			{
+				mantissa = mantissa * 10 + (*p - '0');
+				if (mantissa)
+					nDigits++;
+				exponent--;
+			}
+		}
+	}
+
+	if (!found)
+	{
+		// Rare spellings (nan, inf) go through strtod, which needs a terminated copy
+		char buffer[64];
+		size_t length = 0;
+		for (p = start; p < end && length + 1 < sizeof(buffer) && !isBlank(*p) && *p != '\n' && *p != '\r'; p++)
+			buffer[length++] = *p;
+		buffer[length] = '\0';
+
+		char *parsed;
+		value = static_cast<float>(strtod(buffer, &parsed));
+		return parsed == buffer ? nullptr : start + (parsed - buffer);
+	}
+
+	if (p < end && (*p == 'e' || *p == 'E'))
+	{
+		int exponentPart;
+		bool exponentFound;
+		const char *next = parseInt(p + 1, end, exponentPart, exponentFound);
+		if (exponentFound)
+		{
+			exponent += exponentPart;
+			p = next;
+		}
+	}
+
+	double result = static_cast<double>(mantissa);
+	if (exponent >= -22 && exponent <= 22 && mantissa < (1ull << 53))
+		result = exponent < 0 ? result / POWERS_OF_10[-exponent] : result * POWERS_OF_10[exponent];
+	else if (mantissa != 0)
+		result *= std::pow(10.0, exponent);
+
+	value = static_cast<float>(negative ? -result : result);
+	return p;
+}
+
+const char *ObjLoader::parseInt(const char *p, const char *end, int &value, bool &found)
+{
+	bool negative = false;
+	if (p < end && (*p == '-' || *p == '+'))
+		negative = *p++ == '-';
+
+	// Saturate instead of overflowing; such indices are out of range anyway
+	int64_t result = 0;
+	found = false;
+	for (; p < end && isDigit(*p); p++, found = true)
+	{
+		if (result < INT32_MAX)
+			result = result * 10 + (*p - '0');
+	}
+
+	if (result > INT32_MAX)
+		result = INT32_MAX;
+
+	value = static_cast<int>(negative ? -result : result);
+	return p;
+}
+
+const char *ObjLoader::parseCorner(const char *p, const char *end, const ObjMesh &mesh, ObjCorner &corner, bool &ok)
+{
+	int index;
+	bool found;
+
+	p = parseInt(p, end, index, found);
+	ok = found && resolveIndex(index, mesh.m_positions.size(), corner.m_position);
+	corner.m_normal = -1;
+
+	// v/vt, v//vn or v/vt/vn; texture coordinates are not used
+	if (ok && p < end && *p == '/')
+	{
+		p = parseInt(p + 1, end, index, found);
+		if (p < end && *p == '/')
+		{
+			p = parseInt(p + 1, end, index, found);
+			ok = found && resolveIndex(index, mesh.m_normals.size(), corner.m_normal);
+		}
+	}
+
+	// Anything else glued to the corner is malformed
+	if (ok && p < end && !isBlank(*p) && *p != '\n' && *p != '\r')
+		ok = false;
+
+	return p;
+}
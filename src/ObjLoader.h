@@ -0,0 +1,73 @@
+/**
+ * @file This file is part of snakesGL.
+ *
+ * @section LICENSE
+ * GNU General Public License v2.0
+ *
+ * Copyright (c) 2018-2019 Rajdeep Konwar, Luke Rohrer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @section DESCRIPTION
+ * Single-pass Wavefront OBJ parser.
+ **/
+
+#ifndef OBJ_LOADER_H
+#define OBJ_LOADER_H
+
+// Use of degrees is deprecated. Use radians instead.
+#ifndef GLM_FORCE_RADIANS
+#define GLM_FORCE_RADIANS
+#endif
+#include <glm/vec3.hpp>
+
+#include <vector>
+
+// One corner of a triangle: 0-based position and normal indices (normal is -1 when the face has none)
+struct ObjCorner
+{
+	int m_position;
+	int m_normal;
+};
+
+// Positions, normals and triangle corners of an OBJ file; faces of any arity are fanned into triangles
+struct ObjMesh
+{
+	std::vector<glm::vec3> m_positions, m_normals;
+	std::vector<ObjCorner> m_corners;		// Three per triangle
+};
+
+// Reads v, vn and f lines in one pass over the file, mapped into memory. Faces may use any of the
+// v, v/vt, v//vn and v/vt/vn forms, with negative (relative) indices; everything else is skipped.
+class ObjLoader
+{
+public:
+	// False if the file cannot be read or has a malformed face
+	static bool load(const char *fileName, ObjMesh &mesh);
+
+	// Parse OBJ text in [begin, end)
+	static bool parse(const char *begin, const char *end, ObjMesh &mesh);
+
+private:
+	static const char *parseFloat(const char *p, const char *end, float &value);
+	static const char *parseInt(const char *p, const char *end, int &value, bool &found);
+	static const char *parseCorner(const char *p, const char *end, const ObjMesh &mesh, ObjCorner &corner, bool &ok);
+};
+
+#endif
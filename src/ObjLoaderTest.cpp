@@ -0,0 +1,141 @@
+/**
+ * @file This file is part of snakesGL.
+ *
+ * @section LICENSE
+ * GNU General Public License v2.0
+ *
+ * Copyright (c) 2018-2019 Rajdeep Konwar, Luke Rohrer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @section DESCRIPTION
+ * Checks ObjLoader::parse on the OBJ spellings and malformed faces it has to handle.
+ **/
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "ObjLoader.h"
+
+static int G_nFailed = 0;
+
+#define CHECK(condition)																\
+	do																					\
+	{																					\
+		if (!(condition))																\
+		{																				\
+			std::cerr << __FILE__ << ":" << __LINE__ << ": " << #condition << std::endl;	\
+			G_nFailed++;																\
+		}																				\
+	} while (0)
+
+static bool parse(const char *text, ObjMesh &mesh)
+{
+	return ObjLoader::parse(text, text + strlen(text), mesh);
+}
+
+static bool corner(const ObjMesh &mesh, size_t i, int position, int normal)
+{
+	return i < mesh.m_corners.size() && mesh.m_corners[i].m_position == position && mesh.m_corners[i].m_normal == normal;
+}
+
+static void testCrlf()
+{
+	ObjMesh mesh;
+	CHECK(parse("v 0 0 0\r\nv 1 0 0\r\nv 0 1 0\r\nvn 0 0 1\r\nf 1//1 2//1 3//1\r\n", mesh));
+	CHECK(mesh.m_positions.size() == 3);
+	CHECK(mesh.m_normals.size() == 1);
+	CHECK(mesh.m_corners.size() == 3);
+	CHECK(mesh.m_positions[1].x == 1.0f);
+	CHECK(corner(mesh, 2, 2, 0));
+}
+
+static void testNegativeIndices()
+{
+	ObjMesh mesh;
+	CHECK(parse("v 0 0 0\nv 1 0 0\nv 0 1 0\nvn 0 0 1\nf -3//-1 -2//-1 -1//-1\n", mesh));
+	CHECK(mesh.m_corners.size() == 3);
+	CHECK(corner(mesh, 0, 0, 0));
+	CHECK(corner(mesh, 1, 1, 0));
+	CHECK(corner(mesh, 2, 2, 0));
+
+	// Relative to the vertices read so far, not to the whole file
+	CHECK(parse("v 0 0 0\nv 1 0 0\nv 0 1 0\nf -1 -2 -3\nv 0 0 1\n", mesh));
+	CHECK(corner(mesh, 0, 2, -1));
+	CHECK(corner(mesh, 2, 0, -1));
+}
+
+static void testCornerForms()
+{
+	const char *vertices = "v 0 0 0\nv 1 0 0\nv 0 1 0\nvt 0 0\nvt 1 0\nvt 0 1\nvn 0 0 1\nvn 0 1 0\n";
+	ObjMesh mesh;
+
+	CHECK(parse((std::string(vertices) + "f 1 2 3\n").c_str(), mesh));
+	CHECK(corner(mesh, 0, 0, -1) && corner(mesh, 1, 1, -1) && corner(mesh, 2, 2, -1));
+
+	CHECK(parse((std::string(vertices) + "f 1/1 2/2 3/3\n").c_str(), mesh));
+	CHECK(corner(mesh, 0, 0, -1) && corner(mesh, 1, 1, -1) && corner(mesh, 2, 2, -1));
+
+	CHECK(parse((std::string(vertices) + "f 1//2 2//2 3//1\n").c_str(), mesh));
+	CHECK(corner(mesh, 0, 0, 1) && corner(mesh, 1, 1, 1) && corner(mesh, 2, 2, 0));
+
+	CHECK(parse((std::string(vertices) + "f 1/1/2 2/2/2 3/3/1\n").c_str(), mesh));
+	CHECK(corner(mesh, 0, 0, 1) && corner(mesh, 1, 1, 1) && corner(mesh, 2, 2, 0));
+}
+
+static void testQuadFan()
+{
+	ObjMesh mesh;
+	CHECK(parse("v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\nf 1 2 3 4\n", mesh));
+	CHECK(mesh.m_corners.size() == 6);
+	CHECK(corner(mesh, 0, 0, -1) && corner(mesh, 1, 1, -1) && corner(mesh, 2, 2, -1));
+	CHECK(corner(mesh, 3, 0, -1) && corner(mesh, 4, 2, -1) && corner(mesh, 5, 3, -1));
+}
+
+static void testMalformedFaces()
+{
+	ObjMesh mesh;
+	const char *vertices = "v 0 0 0\nv 1 0 0\nv 0 1 0\nvn 0 0 1\n";
+
+	CHECK(!parse((std::string(vertices) + "f 1 2 4\n").c_str(), mesh));		// Past the last position
+	CHECK(!parse((std::string(vertices) + "f 0 1 2\n").c_str(), mesh));		// OBJ indices are 1-based
+	CHECK(!parse((std::string(vertices) + "f -4 1 2\n").c_str(), mesh));		// Before the first position
+	CHECK(!parse((std::string(vertices) + "f 1//2 2//1 3//1\n").c_str(), mesh));	// Past the last normal
+	CHECK(!parse((std::string(vertices) + "f 1 2\n").c_str(), mesh));			// Fewer than three corners
+}
+
+int main()
+{
+	testCrlf();
+	testNegativeIndices();
+	testCornerForms();
+	testQuadFan();
+	testMalformedFaces();
+
+	if (G_nFailed)
+	{
+		std::cerr << G_nFailed << " check(s) failed" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	std::cout << "ObjLoader: all checks passed" << std::endl;
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,128 @@
+/**
+ * @file This file is part of snakesGL.
+ *
+ * @section LICENSE
+ * GNU General Public License v2.0
+ *
+ * Copyright (c) 2018-2019 Rajdeep Konwar, Luke Rohrer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @section DESCRIPTION
+ * Sorted render queue.
+ **/
+
+#include <algorithm>
+#include <cstring>
+
+#include "RenderQueue.h"
+
+// Static data members
+bool RenderQueue::m_depthPrepass = false;
+int RenderQueue::m_nItems = 0;
+int RenderQueue::m_nBatches = 0;
+std::vector<DrawItem> RenderQueue::m_items;
+
+static unsigned G_nextSortId = 0;
+
+Drawable::Drawable() : m_sortId(G_nextSortId++) {}
+
+// | pass: 4 | program: 12 | mesh: 16 | depth: 32 |
+uint64_t RenderQueue::makeKey(RenderPass pass, const Shader &shader, const Drawable &drawable, float depth)
+{
+	// Non-negative IEEE floats sort like their bit patterns
+	depth = std::max(depth, 0.0f);
+	uint32_t depthBits;
+	memcpy(&depthBits, &depth, sizeof(depthBits));
+
+	return	(static_cast<uint64_t>(pass) << 60) |
+			(static_cast<uint64_t>(shader.m_id & 0xFFF) << 48) |
+			(static_cast<uint64_t>(drawable.m_sortId & 0xFFFF) << 32) |
+			static_cast<uint64_t>(depthBits);
+}
+
+void RenderQueue::submit(RenderPass pass, Shader &shader, Drawable &drawable, const glm::mat4 &modelView, float depth, GLint material)
+{
+	DrawItem item;
+	item.key = makeKey(pass, shader, drawable, depth);
+	item.shader = &shader;
+	item.drawable = &drawable;
+	item.modelView = modelView;
+	item.material = material;
+
+	m_items.push_back(item);
+}
+
+void RenderQueue::drawPasses(RenderPass first, RenderPass last, bool depthOnly)
+{
+	uint64_t lowKey = static_cast<uint64_t>(first) << 60;
+	uint64_t highKey = static_cast<uint64_t>(last) << 60;
+
+	size_t begin = 0;
+	while (begin < m_items.size() && m_items[begin].key < lowKey)
+		begin++;
+
+	while (begin < m_items.size() && m_items[begin].key < highKey)
+	{
+		// Extend the batch over every following item with the same program and drawable
+		size_t end = begin + 1;
+		while (end < m_items.size() && m_items[end].key < highKey && m_items[end].shader == m_items[begin].shader && m_items[end].drawable == m_items[begin].drawable)
+			end++;
+
+		// Without a working depth-only variant the full program still writes the right depth
+		Shader *shader = m_items[begin].shader;
+		if (depthOnly && shader->m_depthOnly && shader->m_depthOnly->m_id)
+			shader = shader->m_depthOnly;
+
+		m_items[begin].drawable->drawBatch(*shader, &m_items[begin], static_cast<int>(end - begin));
+		m_nBatches++;
+
+		begin = end;
+	}
+}
+
+void RenderQueue::flush()
+{
+	std::sort(m_items.begin(), m_items.end(), [](const DrawItem &a, const DrawItem &b) { return a.key < b.key; });
+
+	m_nItems = static_cast<int>(m_items.size());
+	m_nBatches = 0;
+
+	if (m_depthPrepass)
+	{
+		// Depth only: no colour writes, cheap fragment shader
+		glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+		drawPasses(PASS_OPAQUE, PASS_LINES, true);
+		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+		// Shade only the fragments that won the depth test; depth is already final
+		glDepthMask(GL_FALSE);
+		glDepthFunc(GL_EQUAL);
+		drawPasses(PASS_OPAQUE, PASS_LINES, false);
+		glDepthFunc(GL_LEQUAL);
+		glDepthMask(GL_TRUE);
+
+		// Lines were not in the pre-pass
+		drawPasses(PASS_LINES, PASS_COUNT, false);
+	}
+	else
+		drawPasses(PASS_OPAQUE, PASS_COUNT, false);
+
+	m_items.clear();
+}
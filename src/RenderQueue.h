@@ -0,0 +1,115 @@
+/**
+ * @file This file is part of snakesGL.
+ *
+ * @section LICENSE
+ * GNU General Public License v2.0
+ *
+ * Copyright (c) 2018-2019 Rajdeep Konwar, Luke Rohrer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @section DESCRIPTION
+ * Sorted render queue.
+ **/
+
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#define GLFW_INCLUDE_GLEXT
+#ifdef __APPLE__
+#define GLFW_INCLUDE_GLCOREARB
+#else
+#include <GL/glew.h>
+#endif
+#include <GLFW/glfw3.h>
+// Use of degrees is deprecated. Use radians instead.
+#ifndef GLM_FORCE_RADIANS
+#define GLM_FORCE_RADIANS
+#endif
+#include <glm/mat4x4.hpp>
+
+#include <cstdint>
+#include <vector>
+
+#include "Shader.h"
+
+// Passes run in this order; within a pass items are grouped by program, then mesh, then depth
+enum RenderPass
+{
+	PASS_OPAQUE,		// Lit geometry, front to back
+	PASS_GROUND,		// The ground quad, after everything standing on it
+	PASS_LINES,			// Outlines and bounding boxes
+	PASS_COUNT
+};
+
+class Drawable;
+
+// One submitted draw
+struct DrawItem
+{
+	uint64_t key;
+	Shader *shader;
+	Drawable *drawable;
+	glm::mat4 modelView;
+	GLint material;			// Index into the material table
+};
+
+// Anything the queue can draw. Consecutive items with the same program and drawable are handed
+// over together, so a drawable can turn them into one instanced draw; drawBatch must draw all
+// count items, whether or not the current sort keys ever batch that drawable.
+class Drawable
+{
+public:
+	Drawable();
+	virtual ~Drawable() {}
+
+	virtual void drawBatch(Shader &shader, const DrawItem *items, int count) = 0;
+
+public:
+	unsigned m_sortId;		// Mesh field of the sort key
+};
+
+class RenderQueue
+{
+public:
+	// depth is the view-space distance used to order items front to back within a batch group
+	static void submit(RenderPass pass, Shader &shader, Drawable &drawable, const glm::mat4 &modelView, float depth, GLint material = 0);
+
+	// Sort everything submitted since the last flush and draw it
+	static void flush();
+
+public:
+	// Draw the opaque and ground passes depth-only first, then shade them with GL_EQUAL so every
+	// covered pixel runs the lit fragment shader once
+	static bool m_depthPrepass;
+
+	static int m_nItems;		// Items drawn by the last flush
+	static int m_nBatches;		// drawBatch calls made by the last flush
+
+private:
+	static uint64_t makeKey(RenderPass pass, const Shader &shader, const Drawable &drawable, float depth);
+
+	// Draw the sorted items of passes [first, last); depthOnly swaps in each program's depth-only variant
+	static void drawPasses(RenderPass first, RenderPass last, bool depthOnly);
+
+private:
+	static std::vector<DrawItem> m_items;
+};
+
+#endif
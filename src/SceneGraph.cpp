@@ -30,381 +30,606 @@
 
 #include <iostream>
 #include <algorithm>
-#include <fstream>
-#include <sstream>
 #include <cstdio>
+#include <cstddef>
+#include <cmath>
+#include <cstring>
 
+#include "MeshFile.h"
+#include "MeshOptimizer.h"
+#include "ObjLoader.h"
 #include "SceneGraph.h"
+#include "StreamBuffer.h"
 #include "Window.h"
 
 Node::~Node() {}
 
+// Static data members
+Frustum Transform::m_frustum;
+int Transform::m_nVisited = 0;
+int Transform::m_nCulled = 0;
+
+void MeshVertex::setAttributes()
+{
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), (GLvoid *)offsetof(MeshVertex, m_position));
+
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(MeshVertex), (GLvoid *)offsetof(MeshVertex, m_normal));
+}
+
+GLenum indexType(size_t nVertices)
+{
+	return nVertices <= 0xFFFF ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+}
+
+GLenum uploadIndices(const std::vector<GLuint> &indices, size_t nVertices)
+{
+	if (indexType(nVertices) == GL_UNSIGNED_SHORT)
+	{
+		std::vector<GLushort> shortIndices(indices.begin(), indices.end());
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, shortIndices.size() * sizeof(GLushort), shortIndices.data(), GL_STATIC_DRAW);
+		return GL_UNSIGNED_SHORT;
+	}
+
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+	return GL_UNSIGNED_INT;
+}
+
+bool Bounds::empty() const
+{
+	return m_min.x > m_max.x;
+}
+
+void Bounds::merge(const glm::vec3 &point)
+{
+	m_min = glm::min(m_min, point);
+	m_max = glm::max(m_max, point);
+}
+
+void Bounds::merge(const Bounds &other)
+{
+	if (other.empty())
+		return;
+
+	m_min = glm::min(m_min, other.m_min);
+	m_max = glm::max(m_max, other.m_max);
+}
+
+// Box enclosing this box after an affine transform (Arvo's method)
+Bounds Bounds::transformed(const glm::mat4 &mtx) const
+{
+	if (empty())
+		return *this;
+
+	Bounds result;
+	result.m_min = result.m_max = glm::vec3(mtx[3]);
+
+	for (int col = 0; col < 3; col++)
+	{
+		for (int row = 0; row < 3; row++)
+		{
+			float a = mtx[col][row] * m_min[col];
+			float b = mtx[col][row] * m_max[col];
+
+			result.m_min[row] += std::min(a, b);
+			result.m_max[row] += std::max(a, b);
+		}
+	}
+
+	return result;
+}
+
+// Gribb-Hartmann: each plane is the last row of P*V plus or minus one of the others
+void Frustum::extract(const glm::mat4 &viewProj)
+{
+	glm::vec4 rows[4];
+	for (int i = 0; i < 4; i++)
+		rows[i] = glm::vec4(viewProj[0][i], viewProj[1][i], viewProj[2][i], viewProj[3][i]);
+
+	m_planes[0] = rows[3] + rows[0];	// left
+	m_planes[1] = rows[3] - rows[0];	// right
+	m_planes[2] = rows[3] + rows[1];	// bottom
+	m_planes[3] = rows[3] - rows[1];	// top
+	m_planes[4] = rows[3] + rows[2];	// near
+	m_planes[5] = rows[3] - rows[2];	// far
+}
+
+// Conservative: a box is rejected only if it lies entirely behind one plane
+bool Frustum::intersects(const Bounds &bounds) const
+{
+	if (bounds.empty())
+		return false;
+
+	// Squared distance from the eye to the nearest point of the box
+	if (m_maxDist > 0.0f)
+	{
+		glm::vec3 nearest = glm::clamp(m_eye, bounds.m_min, bounds.m_max);
+		glm::vec3 delta = nearest - m_eye;
+		if (glm::dot(delta, delta) > m_maxDist * m_maxDist)
+			return false;
+	}
+
+	for (const auto &plane : m_planes)
+	{
+		// Corner furthest along the plane normal
+		glm::vec3 corner(	plane.x >= 0.0f ? bounds.m_max.x : bounds.m_min.x,
+							plane.y >= 0.0f ? bounds.m_max.y : bounds.m_min.y,
+							plane.z >= 0.0f ? bounds.m_max.z : bounds.m_min.z);
+
+		if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f)
+			return false;
+	}
+
+	return true;
+}
+
 Transform::Transform(const glm::mat4 &mtx) : m_tMtx(mtx) {}
 
 Transform::~Transform()
 {
-	glDeleteVertexArrays(1, &m_bboxVAO);
-	glDeleteVertexArrays(1, &m_snakeVAO);
-
-	glDeleteBuffers(1, &m_bboxVBO);
-	glDeleteBuffers(1, &m_snakeVBO);
+	GLState::deleteVertexArrays(1, &m_snakeVAO);
+	GLState::deleteBuffers(1, &m_snakeVBO);
 }
 
 void Transform::addChild(Node *child)
 {
 	m_ptrs.push_back(child);
+	child->setParent(this);
+	markDirty();
 }
 
 // untested: don't use
 void Transform::removeChild()
 {
 	m_ptrs.pop_back();
+	markDirty();
 }
 
-void Transform::generateBoundingBox()
-{
-	float xMin = m_position.x;
-	float xMax = m_position.x + m_size.x;
-	float yMin = m_position.y - m_size.y;
-	float yMax = m_position.y;
-	float zMin = m_position.z;
-	float zMax = m_position.z + m_size.z;
-
-	// The 8 vertices of the bounding box
-	glm::vec3 v1(xMin, yMin, zMin);
-	glm::vec3 v2(xMax, yMin, zMin);
-	glm::vec3 v3(xMax, yMax, zMin);
-	glm::vec3 v4(xMin, yMax, zMin);
-	glm::vec3 v5(xMin, yMin, zMax);
-	glm::vec3 v6(xMax, yMin, zMax);
-	glm::vec3 v7(xMax, yMax, zMax);
-	glm::vec3 v8(xMin, yMax, zMax);
-
-	// Construct the cuboidal bounding box
-	m_bboxVertices.clear();
-	m_bboxVertices.push_back(v1);	m_bboxVertices.push_back(v2);
-	m_bboxVertices.push_back(v2);	m_bboxVertices.push_back(v3);
-	m_bboxVertices.push_back(v3);	m_bboxVertices.push_back(v4);
-	m_bboxVertices.push_back(v4);	m_bboxVertices.push_back(v1);
-	m_bboxVertices.push_back(v1);	m_bboxVertices.push_back(v5);
-	m_bboxVertices.push_back(v2);	m_bboxVertices.push_back(v6);
-	m_bboxVertices.push_back(v3);	m_bboxVertices.push_back(v7);
-	m_bboxVertices.push_back(v4);	m_bboxVertices.push_back(v8);
-	m_bboxVertices.push_back(v5);	m_bboxVertices.push_back(v6);
-	m_bboxVertices.push_back(v6);	m_bboxVertices.push_back(v7);
-	m_bboxVertices.push_back(v7);	m_bboxVertices.push_back(v8);
-	m_bboxVertices.push_back(v8);	m_bboxVertices.push_back(v5);
-
-	glGenVertexArrays(1, &m_bboxVAO);
-	glGenBuffers(1, &m_bboxVBO);
-
-	glBindVertexArray(m_bboxVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, m_bboxVBO);
-
-	glBufferData(GL_ARRAY_BUFFER, m_bboxVertices.size() * sizeof(glm::vec3), &m_bboxVertices[0], GL_STATIC_DRAW);
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (GLvoid*)0);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindVertexArray(0);
+void Transform::setParent(Transform *parent)
+{
+	m_parent = parent;
+	m_moved = true;
+	markDirty();
 }
 
-void Transform::drawBoundingBox(const GLuint &shaderProgram, const glm::mat4 &mtx)
+// Flag this subtree's bounds and every ancestor's as stale (a dirty node's ancestors are always dirty)
+void Transform::markDirty()
 {
-	glm::mat4 modelView = mtx;
-  
-	GLuint uProjection = glGetUniformLocation(shaderProgram, "u_projection");
-	GLuint uModelView = glGetUniformLocation(shaderProgram, "u_modelView");
-	GLuint uCamPos = glGetUniformLocation(shaderProgram, "u_camPos");
-	GLuint uDestroyed = glGetUniformLocation(shaderProgram, "u_destroyed");
-	GLuint uBBoxColor = glGetUniformLocation(shaderProgram, "u_bboxColor");
-	GLuint uFog = glGetUniformLocation(shaderProgram, "u_fog");
+	m_dirty = true;
 
-	glUniformMatrix4fv(uProjection, 1, GL_FALSE, &Window::m_P[0][0]);
-	glUniformMatrix4fv(uModelView, 1, GL_FALSE, &modelView[0][0]);
-	glUniform3f(uCamPos, Window::m_camPos.x, Window::m_camPos.y, Window::m_camPos.z);
-	glUniform1i(uDestroyed, this->m_destroyed);
-	glUniform1i(uBBoxColor, this->m_bboxColor);
-	glUniform1i(uFog, Window::m_fog);
-  
-	glBindVertexArray(m_bboxVAO);
-	glLineWidth(1.0f);
-	glDrawArrays(GL_LINES, 0, static_cast<GLsizei>(m_bboxVertices.size()));
-	glBindVertexArray(0);
+	for (Transform *node = m_parent; node && !node->m_dirty; node = node->m_parent)
+		node->m_dirty = true;
 }
 
-void Transform::generateSnakeContour()
+void Transform::destroy()
 {
-	static float headPos[4] = { 0.78f, 0.78f, 1.8f, 0.78f };
+	m_destroyed = true;
+	queueChange();
+}
 
-	for (int i = 0; i < 4; i++)
-		headPos[i] += Window::m_velocity;
+void Transform::trackChanges(std::vector<GLuint> *changedIds, GLuint recordId)
+{
+	m_changedIds = changedIds;
+	m_recordId = recordId;
+	queueChange();
+}
 
-	// Construct the head contours
-	glm::vec3 vh1(-1.0f, headPos[0], 0.01f);
-	glm::vec3 vh2( 1.0f, headPos[1], 0.01f);
-	glm::vec3 vh3( 0.0f, headPos[2], 0.01f);
-	glm::vec3 vh4( 0.0f, headPos[3], 0.76f);
+void Transform::queueChange()
+{
+	if (m_changedIds && !m_changeQueued)
+	{
+		m_changedIds->push_back(m_recordId);
+		m_changeQueued = true;
+	}
+}
+
+void Transform::beginFrame(const glm::mat4 &viewProj, const glm::vec3 &eye, float maxDist)
+{
+	m_frustum.extract(viewProj);
+	m_frustum.m_eye = eye;
+	m_frustum.m_maxDist = maxDist;
+
+	m_nVisited = 0;
+	m_nCulled = 0;
+}
+
+bool Transform::visible(const Bounds &bounds)
+{
+	return m_frustum.intersects(bounds);
+}
+
+// Only dirty subtrees are revisited; clean ones return their cached bounds
+Bounds Transform::bounds(const glm::mat4 &parentMtx, bool force)
+{
+	if (!m_dirty && !force)
+		return m_bounds;
+
+	force = force || m_moved;
+	m_worldMtx = parentMtx * m_tMtx;
+	if (force)
+		queueChange();
+
+	m_bounds = Bounds();
+	for (const auto &node : m_ptrs)
+		m_bounds.merge(node->bounds(m_worldMtx, force));
+
+	m_dirty = false;
+	m_moved = false;
+
+	return m_bounds;
+}
+
+// Build the snake's outline once in model space; it follows the snake through m_tMtx
+void Transform::generateSnakeContour(int nBody)
+{
+	// Head: base edges, tip and ridge
+	glm::vec3 headLeft(-1.0f, 0.78f, 0.01f);
+	glm::vec3 headRight(1.0f, 0.78f, 0.01f);
+	glm::vec3 headTip(0.0f, 1.8f, 0.01f);
+	glm::vec3 headTop(0.0f, 0.78f, 0.76f);
 
 	m_snakeVertices.clear();
-	m_snakeVertices.push_back(vh1);		m_snakeVertices.push_back(vh3);
-	m_snakeVertices.push_back(vh3);		m_snakeVertices.push_back(vh2);
-	m_snakeVertices.push_back(vh1);		m_snakeVertices.push_back(vh4);
-	m_snakeVertices.push_back(vh4);		m_snakeVertices.push_back(vh2);
-
-	static float bodyPos[11] = { -0.53f, -0.53f, -0.53f,  0.27f,  0.27f, 0.44f,
-								 -1.53f, -1.53f, -1.53f, -2.53f, -2.53f };
-
-	for (int i = 0; i < 11; i++)
-		bodyPos[i] += Window::m_velocity;
-
-	// Construct the first body part attached to head
-	glm::vec3 v1(-0.5f, bodyPos[0], 0.01f);
-	glm::vec3 v2( 0.5f, bodyPos[1], 0.01f);
-	glm::vec3 v3( 0.0f, bodyPos[2], 0.51f);
-	glm::vec3 v4(-0.5f, bodyPos[3], 0.01f);
-	glm::vec3 v5( 0.5f, bodyPos[4], 0.01f);
-	glm::vec3 v6( 0.0f, bodyPos[5], 0.51f);
-
-	m_snakeVertices.push_back(v4);		m_snakeVertices.push_back(vh1);
-	m_snakeVertices.push_back(v5);		m_snakeVertices.push_back(vh2);
-
-	m_snakeVertices.push_back(v1);		m_snakeVertices.push_back(v3);
-	m_snakeVertices.push_back(v3);		m_snakeVertices.push_back(v2);
-	m_snakeVertices.push_back(v1);		m_snakeVertices.push_back(v4);
-	m_snakeVertices.push_back(v2);		m_snakeVertices.push_back(v5);
-	m_snakeVertices.push_back(v4);		m_snakeVertices.push_back(v6);
-	m_snakeVertices.push_back(v6);		m_snakeVertices.push_back(v5);
-
-	// Second body part
-	glm::vec3 v7(-0.5f, bodyPos[6], 0.01f);
-	glm::vec3 v8( 0.5f, bodyPos[7], 0.01f);
-	glm::vec3 v9( 0.0f, bodyPos[8], 0.51f);
-
-	m_snakeVertices.push_back(v7);		m_snakeVertices.push_back(v9);
-	m_snakeVertices.push_back(v9);		m_snakeVertices.push_back(v8);
-	m_snakeVertices.push_back(v7);		m_snakeVertices.push_back(v1);
-	m_snakeVertices.push_back(v8);		m_snakeVertices.push_back(v2);
-
-	// Third body part
-	glm::vec3 v10(-0.5f, bodyPos[9],  0.01f);
-	glm::vec3 v11( 0.5f, bodyPos[10], 0.01f);
-
-	m_snakeVertices.push_back(v10);		m_snakeVertices.push_back(v7);
-	m_snakeVertices.push_back(v11);		m_snakeVertices.push_back(v8);
+	m_snakeVertices.push_back(headLeft);	m_snakeVertices.push_back(headTip);
+	m_snakeVertices.push_back(headTip);		m_snakeVertices.push_back(headRight);
+	m_snakeVertices.push_back(headLeft);	m_snakeVertices.push_back(headTop);
+	m_snakeVertices.push_back(headTop);		m_snakeVertices.push_back(headRight);
+
+	// Cross-section rings along the body; the first sits under the head with a raised ridge
+	glm::vec3 prevLeft(-0.5f, 0.27f, 0.01f);
+	glm::vec3 prevRight(0.5f, 0.27f, 0.01f);
+	glm::vec3 prevTop(0.0f, 0.44f, 0.51f);
+
+	m_snakeVertices.push_back(prevLeft);	m_snakeVertices.push_back(headLeft);
+	m_snakeVertices.push_back(prevRight);	m_snakeVertices.push_back(headRight);
+	m_snakeVertices.push_back(prevLeft);	m_snakeVertices.push_back(prevTop);
+	m_snakeVertices.push_back(prevTop);		m_snakeVertices.push_back(prevRight);
+
+	// One ring per remaining body part, spaced one unit apart
+	for (int i = 1; i < nBody; i++)
+	{
+		float y = -0.53f - static_cast<float>(i - 1);
+
+		glm::vec3 left(-0.5f, y, 0.01f);
+		glm::vec3 right(0.5f, y, 0.01f);
+		glm::vec3 top(0.0f, y, 0.51f);
+
+		m_snakeVertices.push_back(left);	m_snakeVertices.push_back(top);
+		m_snakeVertices.push_back(top);		m_snakeVertices.push_back(right);
+		m_snakeVertices.push_back(left);	m_snakeVertices.push_back(prevLeft);
+		m_snakeVertices.push_back(right);	m_snakeVertices.push_back(prevRight);
+
+		prevLeft = left;
+		prevRight = right;
+	}
+
+	// Tail tapers to the ground one unit behind the last ring
+	float yTail = -0.53f - static_cast<float>(nBody - 1);
+	glm::vec3 tailLeft(-0.5f, yTail, 0.01f);
+	glm::vec3 tailRight(0.5f, yTail, 0.01f);
+
+	m_snakeVertices.push_back(tailLeft);	m_snakeVertices.push_back(prevLeft);
+	m_snakeVertices.push_back(tailRight);	m_snakeVertices.push_back(prevRight);
 
 	glGenVertexArrays(1, &m_snakeVAO);
 	glGenBuffers(1, &m_snakeVBO);
 
-	glBindVertexArray(m_snakeVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, m_snakeVBO);
+	GLState::bindVertexArray(m_snakeVAO);
+	GLState::bindBuffer(GL_ARRAY_BUFFER, m_snakeVBO);
 
 	glBufferData(GL_ARRAY_BUFFER, m_snakeVertices.size() * sizeof(glm::vec3), &m_snakeVertices[0], GL_STATIC_DRAW);
 	glEnableVertexAttribArray(0);
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (GLvoid*)0);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindVertexArray(0);
+	GLState::bindBuffer(GL_ARRAY_BUFFER, 0);
+	GLState::bindVertexArray(0);
 }
 
-void Transform::drawSnakeContour(const GLuint &shaderProgram, const glm::mat4 &mtx)
+void Transform::drawSnakeContour(Shader &shader, const glm::mat4 &mtx)
 {
-	GLuint uProjection = glGetUniformLocation(shaderProgram, "u_projection");
-	glUniformMatrix4fv(uProjection, 1, GL_FALSE, &Window::m_P[0][0]);
-
-	glm::mat4 modelView = mtx;
-	GLuint uModelView = glGetUniformLocation(shaderProgram, "u_modelView");
-	glUniformMatrix4fv(uModelView, 1, GL_FALSE, &modelView[0][0]);
-
-	GLuint uCamPos = glGetUniformLocation(shaderProgram, "u_camPos");
-	glUniform3f(uCamPos, Window::m_camPos.x, Window::m_camPos.y, Window::m_camPos.z);
+	RenderQueue::submit(PASS_LINES, shader, *this, mtx * m_tMtx, 0.0f);
+}
 
-	GLuint uFog = glGetUniformLocation(shaderProgram, "u_fog");
-	glUniform1i(uFog, Window::m_fog);
+void Transform::drawBatch(Shader &shader, const DrawItem *items, int count)
+{
+	shader.use();
+	GLState::bindVertexArray(m_snakeVAO);
+	GLState::lineWidth(2.0f);
 
-	glBindVertexArray(m_snakeVAO);
-	glLineWidth(2.0f);
-	glDrawArrays(GL_LINES, 0, static_cast<GLsizei>(m_snakeVertices.size()));
-	glBindVertexArray(0);
+	for (int i = 0; i < count; i++)
+	{
+		shader.setUniform(U_MODEL_VIEW, items[i].modelView);
+		glDrawArrays(GL_LINES, 0, static_cast<GLsizei>(m_snakeVertices.size()));
+	}
 }
 
-void Transform::draw(const GLuint &shaderProgram, const glm::mat4 &mtx)
+void Transform::draw(Shader &shader, const glm::mat4 &mtx, int material)
 {
 	if (m_destroyed)
 		return;
 
+	// Reject the whole subtree before any of it reaches GL
+	if (!m_frustum.intersects(m_bounds))
+	{
+		m_nCulled++;
+		return;
+	}
+	m_nVisited++;
+
+	if (m_material >= 0)
+		material = m_material;
+
 	for (const auto &node : m_ptrs)
-		node->draw(shaderProgram, mtx * m_tMtx);
+		node->draw(shader, mtx * m_tMtx, material);
 }
 
 void Transform::update(const glm::mat4 &mtx)
 {
 	m_tMtx = mtx;
+	m_moved = true;
+	markDirty();
 }
 
-void Geometry::load(const char *fileName)
+BoundingBoxes::BoundingBoxes(const std::vector<Node *> &transforms) : m_transforms(transforms)
 {
-	std::ifstream in(fileName);
-	if (!in.is_open())
+	// The 12 edges of the unit cube; each instance stretches it to [min, max]
+	const GLfloat corners[24][3] = {	{ 0, 0, 0 }, { 1, 0, 0 },	{ 1, 0, 0 }, { 1, 1, 0 },
+										{ 1, 1, 0 }, { 0, 1, 0 },	{ 0, 1, 0 }, { 0, 0, 0 },
+										{ 0, 0, 0 }, { 0, 0, 1 },	{ 1, 0, 0 }, { 1, 0, 1 },
+										{ 1, 1, 0 }, { 1, 1, 1 },	{ 0, 1, 0 }, { 0, 1, 1 },
+										{ 0, 0, 1 }, { 1, 0, 1 },	{ 1, 0, 1 }, { 1, 1, 1 },
+										{ 1, 1, 1 }, { 0, 1, 1 },	{ 0, 1, 1 }, { 0, 0, 1 }	};
+
+	glGenVertexArrays(1, &m_VAO);
+	glGenBuffers(1, &m_VBO);
+
+	GLState::bindVertexArray(m_VAO);
+
+	GLState::bindBuffer(GL_ARRAY_BUFFER, m_VBO);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (GLvoid *)0);
+
+	// Instance data lives in the stream buffer; bindInstances points at it for each draw
+	for (GLuint i = 1; i <= 3; i++)
 	{
-		std::cerr << "Error loading file " << fileName << std::endl;
-		exit(EXIT_FAILURE);
+		glEnableVertexAttribArray(i);
+		glVertexAttribDivisor(i, 1);
 	}
 
-	std::string line, next;
-	while (getline(in, line))
+	GLState::bindBuffer(GL_ARRAY_BUFFER, 0);
+	GLState::bindVertexArray(0);
+}
+
+BoundingBoxes::~BoundingBoxes()
+{
+	GLState::deleteVertexArrays(1, &m_VAO);
+
+	GLState::deleteBuffers(1, &m_VBO);
+}
+
+void BoundingBoxes::draw(Shader &shader, const glm::mat4 &mtx)
+{
+	if (!m_transforms.empty())
+		RenderQueue::submit(PASS_LINES, shader, *this, mtx, 0.0f);
+}
+
+void BoundingBoxes::drawBatch(Shader &shader, const DrawItem *items, int count)
+{
+	// Boxes hang down from m_position in y and extend up from it in x and z
+	m_instances.clear();
+	for (const auto &node : m_transforms)
 	{
-		// normals
-		if (line[0] == 'v' && line[1] == 'n')
-		{
-			std::istringstream ss(line);
-			std::vector<std::string> tokens;
-
-			while (ss)
-			{
-				if (!getline(ss, next, ' ') || tokens.size() == 4)
-					break;
-
-				tokens.push_back(next);
-			}
-
-			float n1 = static_cast<float>(atof(tokens[1].c_str()));
-			float n2 = static_cast<float>(atof(tokens[2].c_str()));
-			float n3 = static_cast<float>(atof(tokens[3].c_str()));
-
-			float mag = sqrtf(pow(n1, 2.0f) + pow(n2, 2.0f) + pow(n3, 2.0f));
-			n1 = (n1 / mag) * 0.5f + 0.5f;
-			n2 = (n2 / mag) * 0.5f + 0.5f;
-			n3 = (n3 / mag) * 0.5f + 0.5f;
-
-			// Populate normals
-			m_normals.push_back(n1);
-			m_normals.push_back(n2);
-			m_normals.push_back(n3);
-		}
+		const Transform *transform = static_cast<const Transform *>(node);
 
-		// vertices
-		else if (line[0] == 'v' && line[1] == ' ')
-		{
-			std::istringstream ss(line);
-			std::vector<std::string> tokens;
+		Instance instance;
+		instance.min = glm::vec3(transform->m_position.x, transform->m_position.y - transform->m_size.y, transform->m_position.z);
+		instance.max = glm::vec3(transform->m_position.x + transform->m_size.x, transform->m_position.y, transform->m_position.z + transform->m_size.z);
+		instance.color = transform->m_bboxColor;
+		m_instances.push_back(instance);
+	}
 
-			while (ss)
-			{
-				if (!getline(ss, next, ' ') || tokens.size() == 4)
-					break;
+	shader.use();
 
-				tokens.push_back(next);
-			}
+	GLintptr offset = StreamBuffer::write(&m_instances[0], m_instances.size() * sizeof(Instance), sizeof(glm::vec4));
 
-			// Populate vertices
-			float val = static_cast<float>(atof(tokens[1].c_str()));
-			m_vertices.push_back(val);
+	GLState::bindVertexArray(m_VAO);
+	bindInstances(offset);
+	GLState::lineWidth(1.0f);
 
-			val = static_cast<float>(atof(tokens[2].c_str()));
-			m_vertices.push_back(val);
+	for (int i = 0; i < count; i++)
+	{
+		shader.setUniform(U_MODEL_VIEW, items[i].modelView);
+		glDrawArraysInstanced(GL_LINES, 0, 24, static_cast<GLsizei>(m_instances.size()));
+	}
+}
 
-			val = static_cast<float>(atof(tokens[3].c_str()));
-			m_vertices.push_back(val);
-		}
+void BoundingBoxes::bindInstances(GLintptr offset)
+{
+	GLState::bindBuffer(GL_ARRAY_BUFFER, StreamBuffer::m_buffer);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Instance), (GLvoid *)(offset + offsetof(Instance, min)));
+	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Instance), (GLvoid *)(offset + offsetof(Instance, max)));
+	glVertexAttribIPointer(3, 1, GL_INT, sizeof(Instance), (GLvoid *)(offset + offsetof(Instance, color)));
+}
 
-		// faces
-		else if (line[0] == 'f')
-		{
-			std::istringstream ss(line);
-			std::vector<std::string> tokens;
+void Geometry::load(const char *fileName)
+{
+	ObjMesh mesh;
+	if (!ObjLoader::load(fileName, mesh))
+	{
+		std::cerr << "Error loading file " << fileName << std::endl;
+		exit(EXIT_FAILURE);
+	}
 
-			while (ss)
-			{
-				if (!getline(ss, next, ' ') || tokens.size() == 4)
-					break;
+	MeshOptimizer::weld(mesh, m_vertices, m_indices);
 
-				tokens.push_back( next );
-			}
+	// File order is arbitrary; reorder for the vertex cache and vertex fetch
+	MeshOptimizer::optimize(m_vertices, m_indices, OPTIMIZE_OVERDRAW);
+	m_hasCpuData = true;
+}
 
-			for (int i = 1; i < 4; i++)
-			{
-				size_t pos = tokens[i].find("//");
-				int index = atoi((tokens[i].substr(0, pos)).c_str()) - 1;
+void Geometry::loadCached(const MeshFile &cached)
+{
+	const MeshFileHeader &header = cached.header();
 
-				// Populate face-indices
-				m_indices.push_back(index);
-			}
-		}
+	// Only the CPU copies; the GPU upload reads the mapping directly
+	m_vertices.assign(cached.vertices(), cached.vertices() + header.vertexCount);
+
+	m_indices.resize(header.indexCount);
+	if (header.indexType == GL_UNSIGNED_SHORT)
+	{
+		const GLushort *indices = static_cast<const GLushort *>(cached.indices());
+		std::copy(indices, indices + header.indexCount, m_indices.begin());
 	}
+	else
+		memcpy(m_indices.data(), cached.indices(), header.indexCount * sizeof(GLuint));
 
-	in.close();
+	m_hasCpuData = true;
 }
 
-Geometry::Geometry(const char *fileName)
+Geometry::Geometry(const char *fileName, bool keepCpuData) : m_fileName(fileName)
 {
-	// parse and load the obj file
-	load(fileName);
+	// The obj file is only parsed when its binary cache is missing or stale
+	MeshFile cached;
+	bool hit = cached.open(fileName);
+	if (hit)
+	{
+		const MeshFileHeader &header = cached.header();
+		m_vertexCount = header.vertexCount;
+		m_indexCount = static_cast<GLsizei>(header.indexCount);
+		m_indexType = header.indexType;
+		m_localBounds.m_min = glm::vec3(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]);
+		m_localBounds.m_max = glm::vec3(header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]);
+
+		if (keepCpuData)
+			loadCached(cached);
+	}
+	else
+	{
+		load(fileName);
+
+		for (const auto &vertex : m_vertices)
+			m_localBounds.merge(vertex.m_position);
+
+		cached.write(m_vertices, m_indices, m_localBounds);
+
+		m_vertexCount = m_vertices.size();
+		m_indexCount = static_cast<GLsizei>(m_indices.size());
+	}
 
 	glGenVertexArrays(1, &m_VAO);
 
 	glGenBuffers(1, &m_VBO);
 	glGenBuffers(1, &m_EBO);
-	glGenBuffers(1, &m_NBO);
 
-	glBindVertexArray(m_VAO);
+	GLState::bindVertexArray(m_VAO);
 
-	glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
-	glBufferData(GL_ARRAY_BUFFER, m_vertices.size() * sizeof(GLfloat), &m_vertices[0], GL_STATIC_DRAW);
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (GLvoid *)0);
+	GLState::bindBuffer(GL_ARRAY_BUFFER, m_VBO);
+	glBufferData(GL_ARRAY_BUFFER, m_vertexCount * sizeof(MeshVertex), hit ? cached.vertices() : m_vertices.data(), GL_STATIC_DRAW);
+	MeshVertex::setAttributes();
 
-	glBindBuffer(GL_ARRAY_BUFFER, m_NBO);
-	glBufferData(GL_ARRAY_BUFFER, m_normals.size() * sizeof(GLfloat), &m_normals[0], GL_STATIC_DRAW);
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), (GLvoid *)0);
+	// Always drawn instanced: a per-instance model-view mat4 (locations 2-5) and material index (6),
+	// streamed each frame; bindInstances points at the data for each draw
+	for (GLuint i = 2; i <= 6; i++)
+	{
+		glEnableVertexAttribArray(i);
+		glVertexAttribDivisor(i, 1);
+	}
 
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_indices.size() * sizeof(GLuint), &m_indices[0], GL_STATIC_DRAW);
+	GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
+	if (hit)	// Cached indices are already in their upload type
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, cached.indexBytes(), cached.indices(), GL_STATIC_DRAW);
+	else
+		m_indexType = uploadIndices(m_indices, m_vertexCount);
 
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindVertexArray(0);
+	GLState::bindBuffer(GL_ARRAY_BUFFER, 0);
+	GLState::bindVertexArray(0);
+
+	if (!keepCpuData)
+		releaseCpuData();
 }
 
 Geometry::~Geometry()
 {
-	glDeleteVertexArrays(1, &m_VAO);
+	GLState::deleteVertexArrays(1, &m_VAO);
+
+	GLState::deleteBuffers(1, &m_VBO);
+	GLState::deleteBuffers(1, &m_EBO);
+}
+
+bool Geometry::hasCpuData() const
+{
+	return m_hasCpuData;
+}
 
-	glDeleteBuffers(1, &m_VBO);
-	glDeleteBuffers(1, &m_NBO);
-	glDeleteBuffers(1, &m_EBO);
+void Geometry::loadCpuData()
+{
+	if (hasCpuData())
+		return;
+
+	// The import is deterministic, so re-importing gives back what was uploaded
+	MeshFile cached;
+	if (cached.open(m_fileName.c_str()))
+		loadCached(cached);
+	else
+		load(m_fileName.c_str());
 }
 
-void Geometry::draw(const GLuint &shaderProgram, const glm::mat4 &mtx)
+void Geometry::releaseCpuData()
 {
-	glUniform3f(glGetUniformLocation(shaderProgram, "dirLight.direction"), 0.0f, 1.0f, 1.0f);
-	glUniform3f(glGetUniformLocation(shaderProgram, "dirLight.ambient"), 0.2f, 0.2f, 0.2f);
-	glUniform3f(glGetUniformLocation(shaderProgram, "dirLight.diffuse"), 1.0f, 1.0f, 1.0f);
-	glUniform3f(glGetUniformLocation(shaderProgram, "dirLight.specular"), 0.3f, 0.3f, 0.3f);
+	std::vector<MeshVertex>().swap(m_vertices);
+	std::vector<GLuint>().swap(m_indices);
+	m_hasCpuData = false;
+}
 
-	glUniform3f(glGetUniformLocation(shaderProgram, "dirLight2.direction"), 0.0f, 0.1f, 1.2f);
-	glUniform3f(glGetUniformLocation(shaderProgram, "dirLight2.ambient"), 0.8f, 0.8f, 0.8f);
-	glUniform3f(glGetUniformLocation(shaderProgram, "dirLight2.diffuse"), 0.6f, 0.6f, 0.6f);
-	glUniform3f(glGetUniformLocation(shaderProgram, "dirLight2.specular"), 0.7f, 0.7f, 0.7f);
+size_t Geometry::gpuBytes() const
+{
+	size_t indexSize = m_indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+	return m_vertexCount * sizeof(MeshVertex) + static_cast<size_t>(m_indexCount) * indexSize;
+}
 
-	GLuint uProjection = glGetUniformLocation(shaderProgram, "u_projection");
-	glUniformMatrix4fv(uProjection, 1, GL_FALSE, &Window::m_P[0][0]);
+size_t Geometry::cpuBytes() const
+{
+	return m_vertices.capacity() * sizeof(MeshVertex) + m_indices.capacity() * sizeof(GLuint);
+}
 
-	glm::mat4 modelView = mtx;
-	GLuint uModelView = glGetUniformLocation(shaderProgram, "u_modelView");
-	glUniformMatrix4fv(uModelView, 1, GL_FALSE, &modelView[0][0]);
+// View-space depth of the origin orders instances front to back
+void Geometry::draw(Shader &shader, const glm::mat4 &mtx, int material)
+{
+	RenderQueue::submit(PASS_OPAQUE, shader, *this, mtx, -mtx[3].z, material);
+}
 
-	GLuint uCamPos = glGetUniformLocation(shaderProgram, "u_camPos");
-	glUniform3f(uCamPos, Window::m_camPos.x, Window::m_camPos.y, Window::m_camPos.z);
+void Geometry::drawBatch(Shader &shader, const DrawItem *items, int count)
+{
+	shader.use();
 
-	GLuint uObstacleType = glGetUniformLocation(shaderProgram, "u_obstacleType");
-	glUniform1i(uObstacleType, this->m_obstacleType);
+	// Instances of different materials share the batch; the shader looks each one up
+	m_instances.clear();
+	for (int i = 0; i < count; i++)
+	{
+		Instance instance;
+		instance.modelView = items[i].modelView;
+		instance.material = items[i].material;
+		m_instances.push_back(instance);
+	}
 
-	GLuint uFog = glGetUniformLocation(shaderProgram, "u_fog");
-	glUniform1i(uFog, Window::m_fog);
+	GLintptr offset = StreamBuffer::write(&m_instances[0], m_instances.size() * sizeof(Instance), sizeof(glm::vec4));
 
-	glBindVertexArray(m_VAO);
-	glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(m_indices.size() * sizeof(GLuint)), GL_UNSIGNED_INT, 0);
+	GLState::bindVertexArray(m_VAO);
+	bindInstances(offset);
+	glDrawElementsInstanced(GL_TRIANGLES, m_indexCount, m_indexType, 0, static_cast<GLsizei>(m_instances.size()));
+}
 
-	glBindVertexArray(0);
+void Geometry::bindInstances(GLintptr offset)
+{
+	GLState::bindBuffer(GL_ARRAY_BUFFER, StreamBuffer::m_buffer);
+	for (GLuint i = 0; i < 4; i++)
+		glVertexAttribPointer(2 + i, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (GLvoid *)(offset + i * sizeof(glm::vec4)));
+	glVertexAttribIPointer(6, 1, GL_INT, sizeof(Instance), (GLvoid *)(offset + offsetof(Instance, material)));
 }
 
 void Geometry::update(const glm::mat4 &mtx) {}
+
+Bounds Geometry::bounds(const glm::mat4 &parentMtx, bool force)
+{
+	return m_localBounds.transformed(parentMtx);
+}
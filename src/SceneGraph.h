@@ -49,9 +49,48 @@
 #include <glm/mat4x4.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <limits>
 #include <list>
+#include <string>
 #include <vector>
 
+#include "MeshVertex.h"
+#include "RenderQueue.h"
+#include "Shader.h"
+
+class MeshFile;
+class Transform;
+
+// GL_UNSIGNED_SHORT for meshes of fewer than 65536 vertices, GL_UNSIGNED_INT otherwise
+GLenum indexType(size_t nVertices);
+
+// Fill the bound GL_ELEMENT_ARRAY_BUFFER, as 16-bit indices when nVertices allows; returns the index type
+GLenum uploadIndices(const std::vector<GLuint> &indices, size_t nVertices);
+
+// Axis-aligned bounding box; empty until something is merged into it
+struct Bounds
+{
+	glm::vec3 m_min = glm::vec3(std::numeric_limits<float>::max());
+	glm::vec3 m_max = glm::vec3(-std::numeric_limits<float>::max());
+
+	bool empty() const;
+	void merge(const glm::vec3 &point);
+	void merge(const Bounds &other);
+	Bounds transformed(const glm::mat4 &mtx) const;
+};
+
+// View frustum as six inward-facing planes (xyz normal, w distance),
+// optionally limited to a sphere of m_maxDist around the eye (0 disables it)
+struct Frustum
+{
+	glm::vec4 m_planes[6];
+	glm::vec3 m_eye;
+	float m_maxDist = 0.0f;
+
+	void extract(const glm::mat4 &viewProj);
+	bool intersects(const Bounds &bounds) const;
+};
+
 // Abstract node class
 class Node
 {
@@ -59,13 +98,20 @@ public:
 	// Pure virtual destructor
 	virtual ~Node() = 0;
 
-	// Pure virtual functions
-	virtual void draw(const GLuint &shaderProgram, const glm::mat4 &mtx) = 0;
+	// Pure virtual functions; draw submits the visible part of the subtree to the RenderQueue
+	// material is inherited down the tree until a transform sets its own
+	virtual void draw(Shader &shader, const glm::mat4 &mtx, int material) = 0;
 	virtual void update(const glm::mat4 &mtx) = 0;
+
+	// World-space bounds of the subtree under parentMtx; force recomputes cached bounds
+	virtual Bounds bounds(const glm::mat4 &parentMtx, bool force) = 0;
+
+	// Only transforms track their parent (geometries are shared between many transforms)
+	virtual void setParent(Transform *parent) {}
 };
 
-// Derived transform class
-class Transform : public Node
+// Derived transform class; as a Drawable it draws the snake contour built by generateSnakeContour
+class Transform : public Node, public Drawable
 {
 public:
 	Transform(const glm::mat4 &mtx);
@@ -74,48 +120,148 @@ public:
 	void addChild(Node *child);
 	void removeChild();
 
-	void generateBoundingBox();
-	void drawBoundingBox(const GLuint &shaderProgram, const glm::mat4 &mtx);
+	void generateSnakeContour(int nBody);
+	void drawSnakeContour(Shader &shader, const glm::mat4 &mtx);
+	void drawBatch(Shader &shader, const DrawItem *items, int count);
 
-	void generateSnakeContour();
-	void drawSnakeContour(const GLuint &shaderProgram, const glm::mat4 &mtx);
-
-	void draw(const GLuint &shaderProgram, const glm::mat4 &mtx);
+	void draw(Shader &shader, const glm::mat4 &mtx, int material);
 	void update(const glm::mat4 &mtx);
 
+	Bounds bounds(const glm::mat4 &parentMtx, bool force);
+	void setParent(Transform *parent);
+
+	// Set the frustum used to cull subtrees in draw and reset the counters;
+	// anything further than maxDist from eye is culled as well (0 disables the distance test)
+	static void beginFrame(const glm::mat4 &viewProj, const glm::vec3 &eye, float maxDist);
+	static bool visible(const Bounds &bounds);
+	static const Frustum &frustum() { return m_frustum; }
+
+	// World matrix as of the last bounds() refresh
+	const glm::mat4 &worldMatrix() const { return m_worldMtx; }
+
+	// Hide the transform (sets m_destroyed) and report the change
+	void destroy();
+
+	// Queue recordId on changedIds whenever the world matrix or m_destroyed changes, so the
+	// GPU-driven path only refreshes the records of transforms that changed. A record is
+	// queued at most once until the renderer applies it, so the list stays bounded while
+	// the path is off
+	void trackChanges(std::vector<GLuint> *changedIds, GLuint recordId);
+
+private:
+	void markDirty();
+	void queueChange();
+
 public:
+	static int m_nVisited;			// Transforms drawn since beginFrame
+	static int m_nCulled;			// Transforms (with their subtrees) rejected since beginFrame
+
 	bool m_destroyed = false;
 	int m_bboxColor = 2;			// 1 for white, 2 for green, 3 for red
 	int m_type = 0;					// 0 for head, 1 for pyramid, 2 for coin, 3 for wall
+	int m_material = -1;			// Material of the subtree's geometry (-1 inherits the parent's)
 	glm::vec3 m_position, m_size;
 
 private:
-	GLuint m_bboxVAO, m_bboxVBO, m_snakeVAO, m_snakeVBO;
+	GLuint m_snakeVAO = 0, m_snakeVBO = 0;
 	glm::mat4 m_tMtx;
+	glm::mat4 m_worldMtx;
 	std::list<Node *> m_ptrs;
-	std::vector<glm::vec3> m_bboxVertices, m_snakeVertices;
+	std::vector<glm::vec3> m_snakeVertices;
+
+	Transform *m_parent = nullptr;
+	Bounds m_bounds;				// World-space bounds of this subtree
+	bool m_dirty = true;			// m_bounds is stale (this or a descendant changed)
+	bool m_moved = true;			// m_tMtx changed, so every descendant's bounds are stale
+
+	std::vector<GLuint> *m_changedIds = nullptr;
+	GLuint m_recordId = 0;
+	bool m_changeQueued = false;	// m_recordId is on m_changedIds; cleared by IndirectRenderer
+
+	static Frustum m_frustum;
+
+	friend class IndirectRenderer;
 };
 
-// derived Geometry class
-class Geometry : public Node
+// Draws the bounding boxes of many transforms with one instanced line draw
+class BoundingBoxes : public Drawable
 {
 public:
-	Geometry(const char *fileName);
+	BoundingBoxes(const std::vector<Node *> &transforms);
+	~BoundingBoxes();
+
+	void draw(Shader &shader, const glm::mat4 &mtx);
+	void drawBatch(Shader &shader, const DrawItem *items, int count);
+
+private:
+	// Point the instance attributes at offset in the stream buffer (VAO must be bound)
+	void bindInstances(GLintptr offset);
+
+private:
+	// Per-box instance attributes (locations 1-3)
+	struct Instance
+	{
+		glm::vec3 min;
+		glm::vec3 max;
+		GLint color;
+	};
+
+	GLuint m_VAO, m_VBO;
+	std::vector<Instance> m_instances;
+	const std::vector<Node *> &m_transforms;
+};
+
+// derived Geometry class; every transform using it becomes one instance of a batched draw
+class Geometry : public Node, public Drawable
+{
+public:
+	// Without keepCpuData the vertices and indices are freed once they are on the GPU
+	Geometry(const char *fileName, bool keepCpuData = true);
 	~Geometry();
 
-	void draw(const GLuint &shaderProgram, const glm::mat4 &mtx);
+	void draw(Shader &shader, const glm::mat4 &mtx, int material);
 	void update(const glm::mat4 &mtx);
+	void drawBatch(Shader &shader, const DrawItem *items, int count);
+
+	Bounds bounds(const glm::mat4 &parentMtx, bool force);
+
+	// CPU copies of the vertices and indices (m_vertices, m_indices), reloaded from the mesh cache on demand
+	bool hasCpuData() const;
+	void loadCpuData();
+	void releaseCpuData();
+
+	// Resident bytes of the GPU buffers and of the CPU copies
+	size_t gpuBytes() const;
+	size_t cpuBytes() const;
 
 private:
 	void load(const char *fileName);
+	void loadCached(const MeshFile &cached);
 
-public:
-	int m_obstacleType = 1;		// 1 for pyramid, 2 for coin, 3 for wall
+	// Point the instance attributes at offset in the stream buffer (VAO must be bound)
+	void bindInstances(GLintptr offset);
 
 private:
-	GLuint m_VAO, m_VBO, m_NBO, m_EBO;
-	std::vector<GLfloat> m_vertices, m_normals;
+	// Per-instance vertex data (locations 2-6)
+	struct Instance
+	{
+		glm::mat4 modelView;
+		GLint material;
+	};
+
+	std::string m_fileName;
+	GLuint m_VAO, m_VBO, m_EBO;
+	GLenum m_indexType;						// GL_UNSIGNED_SHORT below 65536 vertices
+	size_t m_vertexCount;					// Uploaded counts; kept when the CPU copies are freed
+	GLsizei m_indexCount;
+	std::vector<MeshVertex> m_vertices;
 	std::vector<GLuint> m_indices;
+	bool m_hasCpuData = false;				// Set by load/loadCached; empty vectors are a valid (empty) mesh
+	std::vector<Instance> m_instances;
+	Bounds m_localBounds;
+
+	friend class MeshArena;
+	friend class IndirectRenderer;
 };
 
 #endif
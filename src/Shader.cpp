@@ -28,7 +28,9 @@
  * Shader manager.
  **/
 
+#include <cstdint>
 #include <cstdio>
+#include <cstring>
 #include <string>
 #include <vector>
 #include <iostream>
@@ -43,118 +45,663 @@
 #endif
 #include <GLFW/glfw3.h>
 
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
 #include "Shader.h"
 
-GLuint LoadShaders(const char *vertexFilePath, const char *fragmentFilePath)
+// Same value for the ARB and KHR versions of parallel_shader_compile
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+// Static data members
+std::vector<Shader *> Shader::m_pendingShaders;
+
+// Linked program binaries, one file per program key
+static const char *PROGRAM_CACHE_DIR = "./cache";
+static const char PROGRAM_BINARY_MAGIC[4] = { 'S', 'G', 'P', 'B' };
+static const uint32_t PROGRAM_BINARY_VERSION = 1;
+
+struct ProgramBinaryHeader
+{
+	char magic[4];
+	uint32_t version;
+	uint64_t key;			// programKey() of the sources and driver it was built from
+	GLenum format;			// Driver-specific format returned by glGetProgramBinary
+	uint32_t length;		// Bytes of binary following the header
+};
+
+// Stages handed to the driver whose results have not been checked yet
+struct PendingProgram
+{
+	std::vector<GLuint> shaderIds;
+	std::vector<std::string> labels;	// Stage label, path and defines, printed with the compile log
+	uint64_t key;						// programKey() for the binary cache
+	bool cache;							// Store the binary once linked
+};
+
+// Names of the UniformId entries, in enum order
+static const char *UNIFORM_NAMES[U_COUNT] =
+{
+	"u_modelView"
+};
+
+Shader::Shader(GLuint programId, PendingProgram *pending) : m_id(programId), m_depthOnly(nullptr), m_pending(pending), m_root(this)
+{
+	for (int i = 0; i < U_COUNT; i++)
+		m_known[i] = -1;
+
+	// Uniforms can only be reflected once the link is done
+	if (m_pending)
+		m_pendingShaders.push_back(this);
+	else
+		reflect();
+}
+
+Shader::~Shader()
+{
+	// The root owns its variants and the depth-only program they share
+	if (m_root == this)
+	{
+		for (auto &variant : m_variants)
+			delete variant.second;
+
+		delete m_depthOnly;
+	}
+
+	if (m_pending)
+	{
+		for (GLuint shaderId : m_pending->shaderIds)
+			glDeleteShader(shaderId);
+
+		delete m_pending;
+		m_pendingShaders.erase(std::remove(m_pendingShaders.begin(), m_pendingShaders.end(), this), m_pendingShaders.end());
+	}
+
+	GLState::deleteProgram(m_id);
+}
+
+void Shader::use()
+{
+	finish();
+	GLState::useProgram(m_id);
+}
+
+// Query every active uniform once so draws never look locations up by name
+void Shader::reflect()
 {
-	// Create the shaders
-	GLuint vertexShaderId = glCreateShader(GL_VERTEX_SHADER);
-	GLuint fragmentShaderId = glCreateShader(GL_FRAGMENT_SHADER);
+	for (int i = 0; i < U_COUNT; i++)
+		m_known[i] = -1;
 
-	// Read the Vertex Shader code from the file
-	std::string vertexShaderCode;
-	std::ifstream vertexShaderStream(vertexFilePath, std::ios::in);
+	if (m_id == 0)
+		return;
 
-	if (vertexShaderStream.is_open())
+	// Attach the shared per-frame block to its fixed binding point
+	GLuint frameDataIndex = glGetUniformBlockIndex(m_id, "FrameData");
+	if (frameDataIndex != GL_INVALID_INDEX)
+		glUniformBlockBinding(m_id, frameDataIndex, FRAME_DATA_BINDING);
+
+	GLuint materialsIndex = glGetUniformBlockIndex(m_id, "Materials");
+	if (materialsIndex != GL_INVALID_INDEX)
+		glUniformBlockBinding(m_id, materialsIndex, MATERIAL_BINDING);
+
+	GLint nUniforms = 0, maxNameLength = 0;
+	glGetProgramiv(m_id, GL_ACTIVE_UNIFORMS, &nUniforms);
+	glGetProgramiv(m_id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+	std::vector<char> nameBuf(static_cast<size_t>(maxNameLength) + 1);
+	for (GLint i = 0; i < nUniforms; i++)
+	{
+		Uniform uniform;
+		GLsizei nameLength = 0;
+		glGetActiveUniform(m_id, static_cast<GLuint>(i), maxNameLength, &nameLength, &uniform.size, &uniform.type, &nameBuf[0]);
+
+		// Uniforms in blocks have no location
+		std::string name(&nameBuf[0], static_cast<size_t>(nameLength));
+		uniform.location = glGetUniformLocation(m_id, name.c_str());
+		if (uniform.location < 0)
+			continue;
+
+		// Arrays are reported as "name[0]"
+		size_t bracket = name.find('[');
+		if (bracket != std::string::npos)
+			name = name.substr(0, bracket);
+
+		uniform.valid = false;
+		m_names[name] = static_cast<int>(m_uniforms.size());
+		m_uniforms.push_back(uniform);
+	}
+
+	for (int i = 0; i < U_COUNT; i++)
+	{
+		auto it = m_names.find(UNIFORM_NAMES[i]);
+		if (it != m_names.end())
+			m_known[i] = it->second;
+	}
+}
+
+GLint Shader::location(UniformId id)
+{
+	finish();
+
+	return (m_known[id] < 0) ? -1 : m_uniforms[m_known[id]].location;
+}
+
+GLint Shader::location(const std::string &name)
+{
+	finish();
+
+	auto it = m_names.find(name);
+	return (it == m_names.end()) ? -1 : m_uniforms[it->second].location;
+}
+
+Shader::Uniform *Shader::find(UniformId id)
+{
+	return (m_known[id] < 0) ? nullptr : &m_uniforms[m_known[id]];
+}
+
+// Compare against the last uploaded value and remember the new one
+bool Shader::changed(Uniform *uniform, const void *value, size_t bytes)
+{
+	if (uniform->valid && !memcmp(uniform->value, value, bytes))
+		return false;
+
+	memcpy(uniform->value, value, bytes);
+	uniform->valid = true;
+	return true;
+}
+
+void Shader::setUniform(UniformId id, GLint value)
+{
+	Uniform *uniform = find(id);
+	if (uniform && changed(uniform, &value, sizeof(GLint)))
+		glUniform1i(uniform->location, value);
+}
+
+void Shader::setUniform(UniformId id, const glm::vec3 &value)
+{
+	Uniform *uniform = find(id);
+	if (uniform && changed(uniform, &value[0], sizeof(glm::vec3)))
+		glUniform3fv(uniform->location, 1, &value[0]);
+}
+
+void Shader::setUniform(UniformId id, const glm::mat4 &value)
+{
+	Uniform *uniform = find(id);
+	if (uniform && changed(uniform, &value[0][0], sizeof(glm::mat4)))
+		glUniformMatrix4fv(uniform->location, 1, GL_FALSE, &value[0][0]);
+}
+
+static const char *stageLabel(GLenum type)
+{
+	switch (type)
+	{
+		case GL_VERTEX_SHADER:			return "Vertex Shader:   ";
+		case GL_TESS_CONTROL_SHADER:	return "Tess control:    ";
+		case GL_TESS_EVALUATION_SHADER:	return "Tess evaluation: ";
+		case GL_FRAGMENT_SHADER:		return "Fragment shader: ";
+		case GL_COMPUTE_SHADER:			return "Compute shader:  ";
+		default:						return "Shader:          ";
+	}
+}
+
+// "FOG MAX_LIGHTS=2" -> "#define FOG\n#define MAX_LIGHTS 2\n"
+static std::string defineBlock(const std::string &defines)
+{
+	std::string block;
+	size_t start = 0;
+
+	while (start < defines.length())
+	{
+		size_t end = defines.find(' ', start);
+		if (end == std::string::npos)
+			end = defines.length();
+
+		std::string define = defines.substr(start, end - start);
+		if (!define.empty())
+		{
+			size_t equals = define.find('=');
+			if (equals != std::string::npos)
+				define[equals] = ' ';
+
+			block += "#define " + define + "\n";
+		}
+
+		start = end + 1;
+	}
+
+	return block;
+}
+
+// Read one stage's source and inject the defines; false if the file could not be opened
+static bool readSource(const char *filePath, const std::string &defines, std::string &shaderCode)
+{
+	std::ifstream shaderStream(filePath, std::ios::in);
+
+	if (shaderStream.is_open())
 	{
 		std::string line = "";
 
-		while (getline(vertexShaderStream, line))
-			vertexShaderCode += "\n" + line;
+		while (getline(shaderStream, line))
+			shaderCode += "\n" + line;
 
-		vertexShaderStream.close();
+		shaderStream.close();
 	}
 	else
 	{
-		std::cerr << "Impossible to open " << vertexFilePath << ". Check to make sure the file exists and you passed in the right filepath!\n";
+		std::cerr << "Impossible to open " << filePath << ". Check to make sure the file exists and you passed in the right filepath!\n";
 		std::cout << "The current working directory is: ";
 
 		// Please for the love of whatever deity/ies you believe in never do something like the next line of code,
 		// Especially on non-Windows systems where you can have the system happily execute "rm -rf ~"
-		int ret = 0;
 #ifdef _WIN32
-		ret = system("CD");
+		system("CD");
 #else
-		ret = system("pwd");
+		system("pwd");
 #endif
 
-		return ret;
+		return false;
 	}
 
-	// Read the Fragment Shader code from the file
-	std::string fragmentShaderCode;
-	std::ifstream fragmentShaderStream(fragmentFilePath, std::ios::in);
-
-	if (fragmentShaderStream.is_open())
+	// Defines must follow #version, which has to stay the first directive
+	if (!defines.empty())
 	{
-		std::string line = "";
+		size_t version = shaderCode.find("#version");
+		size_t lineEnd = (version == std::string::npos) ? 0 : shaderCode.find('\n', version);
+		if (lineEnd == std::string::npos)
+			lineEnd = shaderCode.length();
+
+		shaderCode.insert(lineEnd, "\n" + defineBlock(defines));
+	}
+
+	return true;
+}
+
+// KHR_parallel_shader_compile: compiles run on driver threads and their completion can be polled.
+// Headers that predate either extension fall back to serial compiles.
+static bool parallelCompileSupported()
+{
+#ifdef __APPLE__
+	return false;
+#else
+	static int supported = -1;
 
-		while (getline(fragmentShaderStream, line))
-			fragmentShaderCode += "\n" + line;
+	if (supported < 0)
+	{
+		supported = 0;
 
-		fragmentShaderStream.close();
+		// Let the driver pick the number of compiler threads
+#if defined(GL_KHR_parallel_shader_compile)
+		if (GLEW_KHR_parallel_shader_compile)
+		{
+			glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+			supported = 1;
+		}
+#endif
+#if defined(GL_ARB_parallel_shader_compile)
+		if (!supported && GLEW_ARB_parallel_shader_compile)
+		{
+			glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+			supported = 1;
+		}
+#endif
 	}
 
-	GLint result = GL_FALSE;
-	int infoLogLength;
+	return supported > 0;
+#endif
+}
+
+// Submit one stage for compilation; the result is checked later by logShader
+static GLuint compileShader(GLenum type, const std::string &shaderCode)
+{
+	GLuint shaderId = glCreateShader(type);
+
+	char const *sourcePointer = shaderCode.c_str();
+	glShaderSource(shaderId, 1, &sourcePointer, NULL);
+	glCompileShader(shaderId);
+
+	return shaderId;
+}
 
-	// Compile Vertex Shader
-	std::cout << "Vertex Shader:   " << vertexFilePath << std::endl;
-	char const *vertexSourcePointer = vertexShaderCode.c_str();
-	glShaderSource(vertexShaderId, 1, &vertexSourcePointer, NULL);
-	glCompileShader(vertexShaderId);
+// Print a stage's label and compile log (blocks until the compile is done)
+static void logShader(GLuint shaderId, const std::string &label)
+{
+	int infoLogLength;
 
-	// Check Vertex Shader
-	glGetShaderiv(vertexShaderId, GL_COMPILE_STATUS, &result);
-	glGetShaderiv(vertexShaderId, GL_INFO_LOG_LENGTH, &infoLogLength);
+	std::cout << label << std::endl;
+	glGetShaderiv(shaderId, GL_INFO_LOG_LENGTH, &infoLogLength);
 
 	if (infoLogLength > 0)
 	{
-		std::vector<char> vertexShaderErrorMessage(static_cast<size_t>(infoLogLength) + 1);
-		glGetShaderInfoLog(vertexShaderId, infoLogLength, NULL, &vertexShaderErrorMessage[0]);
-		std::cerr << &vertexShaderErrorMessage[0] << std::endl;
+		std::vector<char> shaderErrorMessage(static_cast<size_t>(infoLogLength) + 1);
+		glGetShaderInfoLog(shaderId, infoLogLength, NULL, &shaderErrorMessage[0]);
+		std::cerr << &shaderErrorMessage[0] << std::endl;
+	}
+}
+
+// glGetProgramBinary/glProgramBinary are core since OpenGL 4.1; drivers may still offer no formats
+static bool programBinarySupported()
+{
+	static int nFormats = -1;
+
+	if (nFormats < 0)
+	{
+		GLint n = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &n);
+		nFormats = n;
 	}
 
-	// Compile Fragment Shader
-	std::cout << "Fragment shader: " << fragmentFilePath;
-	char const *fragmentSourcePointer = fragmentShaderCode.c_str();
-	glShaderSource(fragmentShaderId, 1, &fragmentSourcePointer, NULL);
-	glCompileShader(fragmentShaderId);
+	return nFormats > 0;
+}
 
-	// Check Fragment Shader
-	glGetShaderiv(fragmentShaderId, GL_COMPILE_STATUS, &result);
-	glGetShaderiv(fragmentShaderId, GL_INFO_LOG_LENGTH, &infoLogLength);
+// 64-bit FNV-1a
+static void hashBytes(uint64_t &hash, const void *data, size_t size)
+{
+	const unsigned char *bytes = static_cast<const unsigned char *>(data);
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ULL;
+	}
+}
 
-	if (infoLogLength > 0)
+static void hashString(uint64_t &hash, const char *str)
+{
+	if (!str)
+		str = "";
+
+	// Include the terminator so "ab" + "c" and "a" + "bc" differ
+	hashBytes(hash, str, strlen(str) + 1);
+}
+
+// Binaries are only valid for the driver that produced them and the exact (preprocessed) sources
+static uint64_t programKey(const std::vector<ShaderStage> &stages, const std::vector<std::string> &sources)
+{
+	uint64_t hash = 14695981039346656037ULL;
+
+	hashString(hash, reinterpret_cast<const char *>(glGetString(GL_VENDOR)));
+	hashString(hash, reinterpret_cast<const char *>(glGetString(GL_RENDERER)));
+	hashString(hash, reinterpret_cast<const char *>(glGetString(GL_VERSION)));
+
+	for (size_t i = 0; i < stages.size(); i++)
+	{
+		hashBytes(hash, &stages[i].type, sizeof(stages[i].type));
+		hashString(hash, sources[i].c_str());
+	}
+
+	return hash;
+}
+
+static std::string programCachePath(uint64_t key)
+{
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+
+	return std::string(PROGRAM_CACHE_DIR) + "/" + name;
+}
+
+// Program from the binary cache, or 0 on a miss or a binary the driver no longer accepts
+static GLuint loadProgramBinary(uint64_t key)
+{
+	std::ifstream file(programCachePath(key).c_str(), std::ios::in | std::ios::binary);
+	if (!file.is_open())
+		return 0;
+
+	ProgramBinaryHeader header;
+	if (!file.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+		memcmp(header.magic, PROGRAM_BINARY_MAGIC, sizeof(header.magic)) ||
+		header.version != PROGRAM_BINARY_VERSION || header.key != key || header.length == 0)
+		return 0;
+
+	std::vector<char> binary(header.length);
+	if (!file.read(&binary[0], header.length))
+		return 0;
+
+	GLuint programId = glCreateProgram();
+	glProgramBinary(programId, header.format, &binary[0], static_cast<GLsizei>(header.length));
+
+	GLint result = GL_FALSE;
+	glGetProgramiv(programId, GL_LINK_STATUS, &result);
+	if (result != GL_TRUE)
 	{
-		std::vector<char> FragmentShaderErrorMessage(static_cast<size_t>(infoLogLength) + 1);
-		glGetShaderInfoLog(fragmentShaderId, infoLogLength, NULL, &FragmentShaderErrorMessage[0]);
-		std::cerr << &FragmentShaderErrorMessage[0] << std::endl;
+		glDeleteProgram(programId);
+		return 0;
+	}
+
+	return programId;
+}
+
+static void saveProgramBinary(uint64_t key, GLuint programId)
+{
+	GLint length = 0;
+	glGetProgramiv(programId, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0)
+		return;
+
+	ProgramBinaryHeader header;
+	memcpy(header.magic, PROGRAM_BINARY_MAGIC, sizeof(header.magic));
+	header.version = PROGRAM_BINARY_VERSION;
+	header.key = key;
+
+	std::vector<char> binary(static_cast<size_t>(length));
+	GLsizei written = 0;
+	glGetProgramBinary(programId, length, &written, &header.format, &binary[0]);
+	if (written <= 0)
+		return;
+	header.length = static_cast<uint32_t>(written);
+
+#ifdef _WIN32
+	_mkdir(PROGRAM_CACHE_DIR);
+#else
+	mkdir(PROGRAM_CACHE_DIR, 0755);
+#endif
+
+	std::ofstream file(programCachePath(key).c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+		return;
+
+	file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+	file.write(&binary[0], written);
+}
+
+// Submit the link of the compiled stages; returns 0 if any stage is missing
+static GLuint linkProgram(const std::vector<GLuint> &shaderIds)
+{
+	for (GLuint shaderId : shaderIds)
+	{
+		if (shaderId == 0)
+		{
+			for (GLuint id : shaderIds)
+				glDeleteShader(id);
+
+			return 0;
+		}
 	}
 
-	// Link the program
 	GLuint programId = glCreateProgram();
-	glAttachShader(programId, vertexShaderId);
-	glAttachShader(programId, fragmentShaderId);
+	for (GLuint shaderId : shaderIds)
+		glAttachShader(programId, shaderId);
+	if (programBinarySupported())
+		glProgramParameteri(programId, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 	glLinkProgram(programId);
 
+	return programId;
+}
+
+// Load a program from the binary cache or hand its stages to the driver. Nothing here waits on
+// the driver: a compiled program comes back with its pending work, to be checked by Shader::finish.
+static GLuint buildProgram(const std::vector<ShaderStage> &stages, const std::string &defines, PendingProgram *&pending)
+{
+	pending = nullptr;
+
+	std::vector<std::string> sources(stages.size());
+	for (size_t i = 0; i < stages.size(); i++)
+	{
+		if (!readSource(stages[i].path.c_str(), defines, sources[i]))
+			return 0;
+	}
+
+	// A cache hit skips compiling and linking altogether
+	bool cached = programBinarySupported();
+	uint64_t key = cached ? programKey(stages, sources) : 0;
+	if (cached)
+	{
+		GLuint programId = loadProgramBinary(key);
+		if (programId)
+		{
+			std::cout << "Cached program: ";
+			for (const auto &stage : stages)
+				std::cout << stage.path << " ";
+			if (!defines.empty())
+				std::cout << "[" << defines << "]";
+			std::cout << std::endl << std::endl;
+
+			return programId;
+		}
+	}
+
+	parallelCompileSupported();
+
+	std::vector<GLuint> shaderIds;
+	for (size_t i = 0; i < stages.size(); i++)
+		shaderIds.push_back(compileShader(stages[i].type, sources[i]));
+
+	GLuint programId = linkProgram(shaderIds);
+	if (programId == 0)
+		return 0;
+
+	pending = new PendingProgram;
+	pending->shaderIds = shaderIds;
+	pending->key = key;
+	pending->cache = cached;
+	for (const auto &stage : stages)
+		pending->labels.push_back(stageLabel(stage.type) + stage.path + (defines.empty() ? "" : " [" + defines + "]"));
+
+	return programId;
+}
+
+bool Shader::ready() const
+{
+	if (!m_pending)
+		return true;
+
+	// Without the extension any status query may block
+	if (!parallelCompileSupported())
+		return false;
+
+	GLint done = GL_FALSE;
+	glGetProgramiv(m_id, GL_COMPLETION_STATUS_KHR, &done);
+	return done == GL_TRUE;
+}
+
+void Shader::finish()
+{
+	if (!m_pending)
+		return;
+
+	for (size_t i = 0; i < m_pending->shaderIds.size(); i++)
+		logShader(m_pending->shaderIds[i], m_pending->labels[i]);
+
+	GLint result = GL_FALSE;
+	int infoLogLength;
+
 	// Check the program
-	glGetProgramiv(programId, GL_LINK_STATUS, &result);
-	glGetProgramiv(programId, GL_INFO_LOG_LENGTH, &infoLogLength);
+	glGetProgramiv(m_id, GL_LINK_STATUS, &result);
+	glGetProgramiv(m_id, GL_INFO_LOG_LENGTH, &infoLogLength);
 
 	if (infoLogLength > 0)
 	{
 		std::vector<char> programErrorMessage(static_cast<size_t>(infoLogLength) + 1);
-		glGetProgramInfoLog(programId, infoLogLength, NULL, &programErrorMessage[0]);
+		glGetProgramInfoLog(m_id, infoLogLength, NULL, &programErrorMessage[0]);
 		std::cerr << &programErrorMessage[0] << std::endl;
 	}
-	std::cout << std::endl << std::endl;
+	std::cout << std::endl;
 
-	glDetachShader(programId, vertexShaderId);
-	glDetachShader(programId, fragmentShaderId);
+	for (GLuint shaderId : m_pending->shaderIds)
+	{
+		glDetachShader(m_id, shaderId);
+		glDeleteShader(shaderId);
+	}
 
-	glDeleteShader(vertexShaderId);
-	glDeleteShader(fragmentShaderId);
+	if (m_pending->cache && result == GL_TRUE)
+		saveProgramBinary(m_pending->key, m_id);
 
-	return programId;
+	delete m_pending;
+	m_pending = nullptr;
+	m_pendingShaders.erase(std::remove(m_pendingShaders.begin(), m_pendingShaders.end(), this), m_pendingShaders.end());
+
+	reflect();
+}
+
+void Shader::finishCompleted()
+{
+	// finish() edits the list
+	std::vector<Shader *> pending = m_pendingShaders;
+	for (Shader *shader : pending)
+	{
+		if (shader->ready())
+			shader->finish();
+	}
+}
+
+static Shader *loadProgram(const std::vector<ShaderStage> &stages)
+{
+	PendingProgram *pending;
+	GLuint programId = buildProgram(stages, "", pending);
+
+	Shader *shader = new Shader(programId, pending);
+	shader->m_stages = stages;
+
+	return shader;
+}
+
+Shader &Shader::variant(const std::string &defines)
+{
+	if (defines.empty())
+		return *this;
+
+	auto it = m_derived.find(defines);
+	if (it != m_derived.end())
+		return *it->second;
+
+	std::string key = m_defines.empty() ? defines : m_defines + " " + defines;
+
+	Shader *&program = m_root->m_variants[key];
+	if (!program)
+	{
+		PendingProgram *pending;
+		GLuint programId = buildProgram(m_root->m_stages, key, pending);
+
+		program = new Shader(programId, pending);
+		program->m_stages = m_root->m_stages;
+		program->m_root = m_root;
+		program->m_defines = key;
+		program->m_depthOnly = m_root->m_depthOnly;
+	}
+
+	m_derived[defines] = program;
+	return *program;
+}
+
+Shader *LoadShaders(const char *vertexFilePath, const char *fragmentFilePath)
+{
+	return loadProgram({	{ GL_VERTEX_SHADER,		vertexFilePath },
+							{ GL_FRAGMENT_SHADER,	fragmentFilePath }	});
+}
+
+Shader *LoadShaders(const char *vertexFilePath, const char *tessControlFilePath, const char *tessEvalFilePath, const char *fragmentFilePath)
+{
+	return loadProgram({	{ GL_VERTEX_SHADER,				vertexFilePath },
+							{ GL_TESS_CONTROL_SHADER,		tessControlFilePath },
+							{ GL_TESS_EVALUATION_SHADER,	tessEvalFilePath },
+							{ GL_FRAGMENT_SHADER,			fragmentFilePath }	});
+}
+
+Shader *LoadComputeShader(const char *computeFilePath)
+{
+	return loadProgram({ { GL_COMPUTE_SHADER, computeFilePath } });
 }
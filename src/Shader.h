@@ -31,6 +31,148 @@
 #ifndef SHADER_H
 #define SHADER_H
 
-GLuint LoadShaders(const char *vertexFilePath, const char *fragmentFilePath);
+#define GLFW_INCLUDE_GLEXT
+#ifdef __APPLE__
+#define GLFW_INCLUDE_GLCOREARB
+#else
+#include <GL/glew.h>
+#endif
+#include <GLFW/glfw3.h>
+// Use of degrees is deprecated. Use radians instead.
+#ifndef GLM_FORCE_RADIANS
+#define GLM_FORCE_RADIANS
+#endif
+#include <glm/mat4x4.hpp>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "GLState.h"
+
+// Uniform block binding points
+constexpr GLuint FRAME_DATA_BINDING = 0;
+constexpr GLuint MATERIAL_BINDING = 1;
+
+// Size of the material table (u_materials in the Materials block)
+constexpr int MAX_MATERIALS = 16;
+
+// Directional light as laid out in a std140 block
+struct DirLight
+{
+	glm::vec4 direction;
+	glm::vec4 ambient;
+	glm::vec4 diffuse;
+	glm::vec4 specular;
+};
+
+// Mirrors the std140 FrameData block declared in every shader
+struct FrameData
+{
+	glm::mat4 projection;
+	glm::mat4 view;
+	glm::vec4 camPos;
+	DirLight dirLight;
+	DirLight dirLight2;
+	GLint fog;
+	GLint pad;
+	glm::vec2 viewport;		// framebuffer size in pixels
+	GLfloat fogMin;			// fog starts at this distance from the eye
+	GLfloat fogMax;			// fully fogged (invisible) beyond this distance
+	GLfloat pad2[2];
+};
+
+// Surface colours as laid out in the std140 Materials block (rgb, w unused)
+struct Material
+{
+	glm::vec4 ambient;
+	glm::vec4 diffuse;
+	glm::vec4 specular;
+};
+
+// Per-draw uniforms used by the draw code; their locations are resolved once at link time
+enum UniformId
+{
+	U_MODEL_VIEW,
+	U_COUNT
+};
+
+// Source file of one pipeline stage
+struct ShaderStage
+{
+	GLenum type;
+	std::string path;
+};
+
+struct PendingProgram;
+
+// Linked shader program with reflected uniforms. Programs are compiled asynchronously: the
+// driver's result is only waited for when the program is first used (or found complete by
+// finishCompleted).
+class Shader
+{
+public:
+	Shader(GLuint programId, PendingProgram *pending = nullptr);
+	~Shader();
+
+	void use();
+
+	// Whether finish() can run without waiting on the driver
+	bool ready() const;
+
+	// Wait for the compile and link, log them and reflect the uniforms
+	void finish();
+
+	// finish() every program the driver is done with (polled, never blocks)
+	static void finishCompleted();
+
+	// This program recompiled with extra space-separated defines ("FOG MAX_LIGHTS=2"), injected
+	// after #version in every stage. Built on first use and cached by key; "" returns this program.
+	Shader &variant(const std::string &defines);
+
+	GLint location(UniformId id);
+	GLint location(const std::string &name);
+
+	// Uploads are skipped when the uniform already holds the value
+	void setUniform(UniformId id, GLint value);
+	void setUniform(UniformId id, const glm::vec3 &value);
+	void setUniform(UniformId id, const glm::mat4 &value);
+
+public:
+	GLuint m_id;
+	Shader *m_depthOnly;		// Same vertex stages with DepthShader.frag, for the depth pre-pass (may be null)
+	std::vector<ShaderStage> m_stages;	// Sources the program (and its variants) is compiled from
+
+private:
+	struct Uniform
+	{
+		GLint location;
+		GLenum type;
+		GLint size;
+		bool valid;				// false until the first upload
+		GLfloat value[16];		// last uploaded value (ints are stored bitwise)
+	};
+
+	void reflect();
+	Uniform *find(UniformId id);
+	bool changed(Uniform *uniform, const void *value, size_t bytes);
+
+private:
+	std::vector<Uniform> m_uniforms;
+	std::unordered_map<std::string, int> m_names;	// name -> index into m_uniforms
+	int m_known[U_COUNT];							// UniformId -> index into m_uniforms (-1 if inactive)
+	PendingProgram *m_pending;						// Driver work not yet checked (null once finished)
+
+	Shader *m_root;									// Program the variants are derived from (owns them)
+	std::string m_defines;							// Defines this program was compiled with
+	std::unordered_map<std::string, Shader *> m_variants;	// Root only: full define key -> program
+	std::unordered_map<std::string, Shader *> m_derived;	// Extra defines -> program, memoised per program
+
+	static std::vector<Shader *> m_pendingShaders;
+};
+
+Shader *LoadShaders(const char *vertexFilePath, const char *fragmentFilePath);
+Shader *LoadShaders(const char *vertexFilePath, const char *tessControlFilePath, const char *tessEvalFilePath, const char *fragmentFilePath);
+Shader *LoadComputeShader(const char *computeFilePath);
 
 #endif
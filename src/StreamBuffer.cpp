@@ -0,0 +1,187 @@
+/**
+ * @file This file is part of snakesGL.
+ *
+ * @section LICENSE
+ * GNU General Public License v2.0
+ *
+ * Copyright (c) 2018-2019 Rajdeep Konwar, Luke Rohrer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @section DESCRIPTION
+ * Streaming buffer for per-frame dynamic data.
+ **/
+
+#include <cstring>
+#include <iostream>
+
+#include "GLState.h"
+#include "StreamBuffer.h"
+
+// Static data members
+GLuint StreamBuffer::m_buffer = 0;
+GLint StreamBuffer::m_uniformAlignment = 256;
+int StreamBuffer::m_nWaits = 0;
+
+bool StreamBuffer::m_persistent = false;
+char *StreamBuffer::m_mapped = nullptr;
+GLsizeiptr StreamBuffer::m_regionSize = 0;
+int StreamBuffer::m_region = 0;
+GLsizeiptr StreamBuffer::m_used = 0;
+GLsync StreamBuffer::m_fences[STREAM_REGIONS] = {};
+
+std::vector<GLuint> StreamBuffer::m_retired;
+int StreamBuffer::m_retireFrames = 0;
+
+bool StreamBuffer::persistentSupported()
+{
+	GLint major = 0, minor = 0;
+	glGetIntegerv(GL_MAJOR_VERSION, &major);
+	glGetIntegerv(GL_MINOR_VERSION, &minor);
+
+	return major > 4 || (major == 4 && minor >= 4);
+}
+
+void StreamBuffer::init(GLsizeiptr regionSize)
+{
+	m_persistent = persistentSupported();
+
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &m_uniformAlignment);
+
+	allocate(regionSize);
+}
+
+void StreamBuffer::allocate(GLsizeiptr regionSize)
+{
+	m_regionSize = regionSize;
+	GLsizeiptr size = m_regionSize * STREAM_REGIONS;
+
+	glGenBuffers(1, &m_buffer);
+	GLState::bindBuffer(GL_COPY_WRITE_BUFFER, m_buffer);
+
+	if (m_persistent)
+	{
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_COPY_WRITE_BUFFER, size, nullptr, flags);
+		m_mapped = static_cast<char *>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, size, flags));
+	}
+	else
+		glBufferData(GL_COPY_WRITE_BUFFER, size, nullptr, GL_STREAM_DRAW);
+}
+
+void StreamBuffer::unmap()
+{
+	if (m_mapped)
+	{
+		GLState::bindBuffer(GL_COPY_WRITE_BUFFER, m_buffer);
+		glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+		m_mapped = nullptr;
+	}
+}
+
+void StreamBuffer::cleanUp()
+{
+	unmap();
+	GLState::deleteBuffers(1, &m_buffer);
+
+	if (!m_retired.empty())
+		GLState::deleteBuffers(static_cast<GLsizei>(m_retired.size()), &m_retired[0]);
+	m_retired.clear();
+
+	for (auto &fence : m_fences)
+	{
+		if (fence)
+			glDeleteSync(fence);
+		fence = nullptr;
+	}
+}
+
+void StreamBuffer::beginFrame()
+{
+	m_region = (m_region + 1) % STREAM_REGIONS;
+	m_used = 0;
+
+	GLsync &fence = m_fences[m_region];
+	if (fence)
+	{
+		// Poll first so a region that is already free costs no flush
+		GLenum status = glClientWaitSync(fence, 0, 0);
+		if (status == GL_TIMEOUT_EXPIRED)
+		{
+			m_nWaits++;
+			do
+				status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+			while (status == GL_TIMEOUT_EXPIRED);
+		}
+
+		glDeleteSync(fence);
+		fence = nullptr;
+	}
+
+	// Every frame that could use a retired buffer has now completed
+	if (m_retireFrames > 0 && --m_retireFrames == 0)
+	{
+		GLState::deleteBuffers(static_cast<GLsizei>(m_retired.size()), &m_retired[0]);
+		m_retired.clear();
+	}
+}
+
+void StreamBuffer::endFrame()
+{
+	m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+GLintptr StreamBuffer::write(const void *data, GLsizeiptr size, GLsizeiptr alignment)
+{
+	GLsizeiptr offset = (m_used + alignment - 1) / alignment * alignment;
+
+	if (offset + size > m_regionSize)
+	{
+		// Out of room: switch to a buffer with bigger regions. Commands already issued this
+		// frame still reference the old one, so it is kept until they have completed.
+		std::cerr << "Stream buffer region of " << m_regionSize << " bytes is too small, growing it" << std::endl;
+
+		unmap();
+		m_retired.push_back(m_buffer);
+		m_retireFrames = STREAM_REGIONS;
+
+		GLsizeiptr regionSize = m_regionSize;
+		while (regionSize < size)
+			regionSize *= 2;
+		allocate(regionSize * 2);
+
+		offset = 0;
+	}
+
+	GLintptr start = m_region * m_regionSize + offset;
+
+	if (m_persistent)
+		memcpy(m_mapped + start, data, size);
+	else
+	{
+		// The fence guarantees the GPU is not reading this range, so skip the driver's sync
+		GLState::bindBuffer(GL_COPY_WRITE_BUFFER, m_buffer);
+		void *mapped = glMapBufferRange(GL_COPY_WRITE_BUFFER, start, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+		memcpy(mapped, data, size);
+		glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+	}
+
+	m_used = offset + size;
+	return start;
+}
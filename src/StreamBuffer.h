@@ -0,0 +1,92 @@
+/**
+ * @file This file is part of snakesGL.
+ *
+ * @section LICENSE
+ * GNU General Public License v2.0
+ *
+ * Copyright (c) 2018-2019 Rajdeep Konwar, Luke Rohrer
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * @section DESCRIPTION
+ * Streaming buffer for per-frame dynamic data.
+ **/
+
+#ifndef STREAM_BUFFER_H
+#define STREAM_BUFFER_H
+
+#define GLFW_INCLUDE_GLEXT
+#ifdef __APPLE__
+#define GLFW_INCLUDE_GLCOREARB
+#else
+#include <GL/glew.h>
+#endif
+#include <GLFW/glfw3.h>
+
+#include <vector>
+
+// Frames the CPU may run ahead of the GPU; the buffer holds one region per frame
+constexpr int STREAM_REGIONS = 3;
+
+// One GL buffer for everything uploaded each frame. Frames write their data into consecutive
+// regions; a fence per region keeps the CPU from overwriting data the GPU has not consumed, so
+// writes are a plain memcpy into a persistently mapped buffer (GL 4.4+) or an unsynchronized
+// map of the region otherwise.
+class StreamBuffer
+{
+public:
+	// regionSize bytes per frame; regions grow if a frame ever needs more
+	static void init(GLsizeiptr regionSize);
+	static void cleanUp();
+
+	// glBufferStorage (persistent, coherent mapping) is core since OpenGL 4.4
+	static bool persistentSupported();
+
+	// Move to the next region, waiting for the GPU if it is still reading it
+	static void beginFrame();
+
+	// Fence the region once every command using it has been issued
+	static void endFrame();
+
+	// Copy size bytes into this frame's region; returns their offset in m_buffer
+	static GLintptr write(const void *data, GLsizeiptr size, GLsizeiptr alignment);
+
+public:
+	static GLuint m_buffer;
+	static GLint m_uniformAlignment;		// Offset alignment for glBindBufferRange on GL_UNIFORM_BUFFER
+	static int m_nWaits;					// Frames that had to wait for their region since init
+
+private:
+	static void allocate(GLsizeiptr regionSize);
+	static void unmap();
+
+private:
+	static bool m_persistent;
+	static char *m_mapped;					// Whole buffer (persistent mapping only)
+	static GLsizeiptr m_regionSize;
+	static int m_region;
+	static GLsizeiptr m_used;				// Bytes written to the current region this frame
+	static GLsync m_fences[STREAM_REGIONS];
+
+	// Buffers replaced by a bigger one; deleted once the GPU is done with them
+	static std::vector<GLuint> m_retired;
+	static int m_retireFrames;
+};
+
+#endif
@@ -28,13 +28,16 @@
  * Window, scene and objects manager.
  **/
 
+#include <algorithm>
 #include <fstream>
 #ifdef _WIN32
 #include <string>
 #endif
 
 #include "Window.h"
+#include "MeshCache.h"
 #include "Sound.h"
+#include "StreamBuffer.h"
 
 #ifdef __APPLE__
 constexpr float SNAKE_SPEED = 0.05f;
@@ -44,6 +47,12 @@ constexpr float SNAKE_SPEED = 0.03f;
 
 constexpr float SPEED_INC = 0.02f;
 
+// Obstacles are grouped into bands of this length along the track so whole bands can be culled
+constexpr float OBSTACLE_BAND_LENGTH = 8.0f;
+
+// Bytes of per-frame dynamic data one frame is expected to stream (frame data, instances, objects)
+constexpr GLsizeiptr STREAM_REGION_SIZE = 1 << 20;
+
 // Static data members
 int Window::m_width;
 int Window::m_height;
@@ -51,11 +60,41 @@ int Window::m_move = 0;
 int Window::m_nBody = 3;
 int Window::m_nTile = 20;
 bool Window::m_fog = true;
+float Window::m_fogMin = 2.0f;
+float Window::m_fogMax = 17.0f;
+bool Window::m_showStats = false;
 float Window::m_velocity = SNAKE_SPEED;
 
 // Global variables
-GLuint G_gridBigShader, G_gridSmallShader, G_snakeShader, G_obstaclesShader;
-GLuint G_boundingBoxShader, G_snakeContourShader, G_velocityShader, G_bezierShader;
+Shader *G_gridShader, *G_snakeShader, *G_obstaclesShader;
+Shader *G_boundingBoxShader, *G_snakeContourShader, *G_bezierShader;
+
+// Per-frame uniform block shared by all programs, streamed through StreamBuffer
+FrameData G_frameData;
+
+// Material table shared by all programs; Transform::m_material indexes it
+enum MaterialId
+{
+	MATERIAL_DEFAULT,
+	MATERIAL_PYRAMID,
+	MATERIAL_COIN,
+	MATERIAL_WALL,
+	MATERIAL_COUNT
+};
+
+const Material G_materials[MATERIAL_COUNT] =
+{
+	// Default (grey)
+	{ glm::vec4(0.2f, 0.2f, 0.2f, 0.0f), glm::vec4(0.5f, 0.5f, 0.5f, 0.0f), glm::vec4(0.5f, 0.5f, 0.5f, 0.0f) },
+	// Pyramid (jade)
+	{ glm::vec4(0.135f, 0.2225f, 0.1575f, 0.0f), glm::vec4(0.54f, 0.89f, 0.63f, 0.0f), glm::vec4(0.5f, 0.5f, 0.5f, 0.0f) },
+	// Coin (gold)
+	{ glm::vec4(0.24725f, 0.1995f, 0.0745f, 0.0f), glm::vec4(0.75164f, 0.60648f, 0.22648f, 0.0f), glm::vec4(0.628281f, 0.555802f, 0.366065f, 0.0f) },
+	// Wall (chrome)
+	{ glm::vec4(0.25f, 0.25f, 0.25f, 0.0f), glm::vec4(0.4f, 0.4f, 0.4f, 0.0f), glm::vec4(0.774597f, 0.774597f, 0.774597f, 0.0f) }
+};
+
+GLuint G_materialUBO;
 
 float G_yPos = 0.0f;
 bool G_drawBbox = false;
@@ -64,16 +103,24 @@ int G_nPyramids = 80;
 int G_nCoins = 5;
 int G_nWalls = 60;
 
-Node *G_pGridBig, *G_pGridSmall;	// Big and small grid position transform mtx
+Grid *G_pGrid;						// Ground grid (single draw)
 Node *G_pSnake;						// Snake transform mtx
 Node *G_pObstacles;
+std::vector<Node *> G_pObstacleBands;	// Children of G_pObstacles, one per OBSTACLE_BAND_LENGTH of track
+BoundingBoxes *G_pBoundingBoxes;
 
 // Individual elements' transform mtx
 Node *G_pHeadMtx, *G_pTailMtx, **G_pPyramidMtx, **G_pCoinMtx, **G_pWallMtx;
-Node *G_pHead, *G_pBody, *G_pTail, *G_pTileBig, *G_pTileSmall, *G_pCoin, *G_pWall;
-std::vector<Node *> G_pTileBigPos, G_pTileSmallPos, G_pBodyMtx, G_pObstaclesList;
+Node *G_pHead, *G_pBody, *G_pTail, *G_pCoin, *G_pWall;
+std::vector<Node *> G_pBodyMtx, G_pObstaclesList;
+
+Bezier *G_pBezier;
 
-Bezier *patch[4];
+// GPU-driven path (OpenGL 4.3+): snake and obstacles culled by a compute shader and drawn indirectly
+MeshArena *G_pMeshArena;
+IndirectRenderer *G_pSnakeIndirect, *G_pObstaclesIndirect;
+Shader *G_cullShader, *G_snakeIndirectShader, *G_obstaclesIndirectShader;
+bool G_gpuDriven = false;
 
 // Default camera parameters
 //glm::vec3 Window::m_camPos(0.0f, 1.8f, 5.0f);		// e | Position of camera (top)
@@ -108,6 +155,20 @@ float Window::randGenY()
 	return (2.0f * static_cast<float>(rando));
 }
 
+// Group node holding the obstacles around track position y
+static Node *obstacleBand(float y)
+{
+	size_t band = static_cast<size_t>(std::max(y, 0.0f) / OBSTACLE_BAND_LENGTH);
+
+	while (G_pObstacleBands.size() <= band)
+	{
+		G_pObstacleBands.push_back(new Transform(glm::mat4(1.0f)));
+		static_cast<Transform *>(G_pObstacles)->addChild(G_pObstacleBands.back());
+	}
+
+	return G_pObstacleBands[band];
+}
+
 // functions as constructor
 void Window::initializeObjects()
 {
@@ -123,14 +184,16 @@ void Window::initializeObjects()
 	}
 
 	std::string lineBuf;
-	std::string gridBigVertShader,		gridBigFragShader;
-	std::string gridSmallVertShader,	gridSmallFragShader;
+	std::string gridVertShader,			gridFragShader;
 	std::string snakeVertShader,		snakeFragShader;
 	std::string obstaclesVertShader,	obstaclesFragShader;
 	std::string boundingBoxVertShader,	boundingBoxFragShader;
 	std::string snakeContourVertShader,	snakeContourFragShader;
 	std::string bezierVertShader,		bezierFragShader;
-	std::string head, body, tail, tileBig, tileSmall, coin, wall;
+	std::string bezierPatchVertShader,	bezierTescShader,	bezierTeseShader;
+	std::string cullCompShader,			snakeIndirectVertShader,	obstaclesIndirectVertShader;
+	std::string depthFragShader;
+	std::string head, body, tail, coin, wall;
 
 	while (getline(confFn, lineBuf))
 	{
@@ -151,14 +214,10 @@ void Window::initializeObjects()
 		std::string varName = lineBuf.substr(k, l - k);
 		std::string varValue = lineBuf.substr(l + 1);
 
-		if (!varName.compare("grid_big_vert_shader"))
-			gridBigVertShader = varValue;
-		else if (!varName.compare("grid_big_frag_shader"))
-			gridBigFragShader = varValue;
-		else if (!varName.compare("grid_small_vert_shader"))
-			gridSmallVertShader = varValue;
-		else if (!varName.compare("grid_small_frag_shader"))
-			gridSmallFragShader = varValue;
+		if (!varName.compare("grid_vert_shader"))
+			gridVertShader = varValue;
+		else if (!varName.compare("grid_frag_shader"))
+			gridFragShader = varValue;
 		else if (!varName.compare("snake_vert_shader"))
 			snakeVertShader = varValue;
 		else if (!varName.compare("snake_frag_shader"))
@@ -179,6 +238,20 @@ void Window::initializeObjects()
 			bezierVertShader = varValue;
 		else if (!varName.compare("bezier_frag_shader"))
 			bezierFragShader = varValue;
+		else if (!varName.compare("bezier_patch_vert_shader"))
+			bezierPatchVertShader = varValue;
+		else if (!varName.compare("bezier_tesc_shader"))
+			bezierTescShader = varValue;
+		else if (!varName.compare("bezier_tese_shader"))
+			bezierTeseShader = varValue;
+		else if (!varName.compare("cull_comp_shader"))
+			cullCompShader = varValue;
+		else if (!varName.compare("snake_indirect_vert_shader"))
+			snakeIndirectVertShader = varValue;
+		else if (!varName.compare("obstacles_indirect_vert_shader"))
+			obstaclesIndirectVertShader = varValue;
+		else if (!varName.compare("depth_frag_shader"))
+			depthFragShader = varValue;
 
 		else if (!varName.compare("head"))
 			head = varValue;
@@ -186,10 +259,6 @@ void Window::initializeObjects()
 			body = varValue;
 		else if (!varName.compare("tail"))
 			tail = varValue;
-		else if (!varName.compare("tile_big"))
-			tileBig = varValue;
-		else if (!varName.compare("tile_small"))
-			tileSmall = varValue;
 		else if (!varName.compare("coin"))
 			coin = varValue;
 		else if (!varName.compare("wall"))
@@ -198,27 +267,72 @@ void Window::initializeObjects()
 
 	confFn.close();
 
+	// Evaluate the Bezier patches on the GPU when tessellation shaders are available
+	bool tessellate = Bezier::tessellationSupported() && !bezierTescShader.empty() && !bezierTeseShader.empty();
+
+	// Cull and draw the snake and obstacles on the GPU when compute shaders are available
+	G_gpuDriven = IndirectRenderer::supported() && !cullCompShader.empty();
+
+	// Submit every shader program before loading anything else; the driver compiles them
+	// (on its own threads with KHR_parallel_shader_compile) while the models load, and each
+	// program is only waited on when first used
+	G_gridShader			= LoadShaders(gridVertShader.c_str(),			gridFragShader.c_str());
+	G_snakeShader			= LoadShaders(snakeVertShader.c_str(),			snakeFragShader.c_str());
+	G_obstaclesShader		= LoadShaders(obstaclesVertShader.c_str(),		obstaclesFragShader.c_str());
+	G_boundingBoxShader		= LoadShaders(boundingBoxVertShader.c_str(),	boundingBoxFragShader.c_str());
+	G_snakeContourShader	= LoadShaders(snakeContourVertShader.c_str(),	snakeContourFragShader.c_str());
+
+	if (tessellate)
+		G_bezierShader		= LoadShaders(bezierPatchVertShader.c_str(), bezierTescShader.c_str(), bezierTeseShader.c_str(), bezierFragShader.c_str());
+	else
+		G_bezierShader		= LoadShaders(bezierVertShader.c_str(),			bezierFragShader.c_str());
+
+	if (G_gpuDriven)
+	{
+		G_cullShader				= LoadComputeShader(cullCompShader.c_str());
+		G_snakeIndirectShader		= LoadShaders(snakeIndirectVertShader.c_str(),		snakeFragShader.c_str());
+		G_obstaclesIndirectShader	= LoadShaders(obstaclesIndirectVertShader.c_str(),	obstaclesFragShader.c_str());
+	}
+
+	// Depth-only variants of the opaque and ground programs for the depth pre-pass
+	if (!depthFragShader.empty())
+	{
+		G_gridShader->m_depthOnly		= LoadShaders(gridVertShader.c_str(),		depthFragShader.c_str());
+		G_snakeShader->m_depthOnly		= LoadShaders(snakeVertShader.c_str(),		depthFragShader.c_str());
+		G_obstaclesShader->m_depthOnly	= LoadShaders(obstaclesVertShader.c_str(),	depthFragShader.c_str());
+
+		if (tessellate)
+			G_bezierShader->m_depthOnly	= LoadShaders(bezierPatchVertShader.c_str(), bezierTescShader.c_str(), bezierTeseShader.c_str(), depthFragShader.c_str());
+		else
+			G_bezierShader->m_depthOnly	= LoadShaders(bezierVertShader.c_str(),		depthFragShader.c_str());
+
+		if (G_gpuDriven)
+		{
+			G_snakeIndirectShader->m_depthOnly		= LoadShaders(snakeIndirectVertShader.c_str(),		depthFragShader.c_str());
+			G_obstaclesIndirectShader->m_depthOnly	= LoadShaders(obstaclesIndirectVertShader.c_str(),	depthFragShader.c_str());
+		}
+	}
+
+	// Submit the permutations up front too, so toggling fog finds them compiled
+	for (Shader *shader : { G_gridShader, G_snakeShader, G_obstaclesShader, G_boundingBoxShader, G_snakeContourShader, G_bezierShader, G_snakeIndirectShader, G_obstaclesIndirectShader })
+	{
+		if (shader)
+			shader->variant("FOG");
+	}
+
 	// Play theme music
 	G_themeSound->Play("./audio/snakes.mp3" , TwoDimensional, true);
 	G_themeSound->SetSoundVolume(0.25f);
 	G_collisionSound->SetSoundVolume(0.5f);
 
-	// Geometry nodes
-	G_pHead			= new Geometry(head.c_str());
-	G_pBody			= new Geometry(body.c_str());
-	G_pTail			= new Geometry(tail.c_str());
-	G_pTileSmall	= new Geometry(tileSmall.c_str());
-	G_pTileBig		= new Geometry(tileBig.c_str());
-	G_pCoin			= new Geometry(coin.c_str());
-	G_pWall			= new Geometry(wall.c_str());
-
-	// Set geometry obstacle type (for color, 1 by default)
-	static_cast<Geometry *>(G_pCoin)->m_obstacleType = 2;
-	static_cast<Geometry *>(G_pWall)->m_obstacleType = 3;
+	// Geometry nodes; the mesh arena of the GPU-driven path reads their vertices and indices
+	G_pHead			= MeshCache::acquire(head, G_gpuDriven);
+	G_pBody			= MeshCache::acquire(body, G_gpuDriven);
+	G_pTail			= MeshCache::acquire(tail, G_gpuDriven);
+	G_pCoin			= MeshCache::acquire(coin, G_gpuDriven);
+	G_pWall			= MeshCache::acquire(wall, G_gpuDriven);
 
 	// Group nodes
-	G_pGridBig		= new Transform(glm::mat4(1.0f));
-	G_pGridSmall	= new Transform(glm::mat4(1.0f));
 	G_pSnake		= new Transform(glm::mat4(1.0f));
 	G_pObstacles	= new Transform(glm::mat4(1.0f));
 
@@ -257,8 +371,8 @@ void Window::initializeObjects()
 	static_cast<Transform *>(G_pSnake)->addChild(G_pTailMtx);
 	static_cast<Transform *>(G_pTailMtx)->addChild(G_pTail);
 
-	// Initialize snake contour (white)
-	static_cast<Transform *>(G_pSnake)->generateSnakeContour();
+	// Initialize snake contour (white), built once in the snake's model space
+	static_cast<Transform *>(G_pSnake)->generateSnakeContour(Window::m_nBody);
 
 	float randX, randY;
 
@@ -278,13 +392,14 @@ void Window::initializeObjects()
 
 		// Type for collision detection
 		static_cast<Transform *>(G_pPyramidMtx[k])->m_type = 1;
+		static_cast<Transform *>(G_pPyramidMtx[k])->m_material = MATERIAL_PYRAMID;
 
 		// Bounding boxes' initial positions and sizes
 		static_cast<Transform *>(G_pPyramidMtx[k])->m_position = glm::vec3(-0.7f + static_cast<float>(randX), 0.7f + static_cast<float>(randY), 0.01f);
 		static_cast<Transform *>(G_pPyramidMtx[k])->m_size = glm::vec3(1.4f, 1.4f, 0.75f);
 
 		// Add pyramid as child of obstacles
-		static_cast<Transform *>(G_pObstacles)->addChild(G_pPyramidMtx[k]);
+		static_cast<Transform *>(obstacleBand(randY))->addChild(G_pPyramidMtx[k]);
 		static_cast<Transform *>(G_pPyramidMtx[k])->addChild(G_pHead);
 
 		// Add to obstacles list (for collision detection)
@@ -305,13 +420,14 @@ void Window::initializeObjects()
 
 		// Type for collision detection
 		static_cast<Transform *>(G_pCoinMtx[k])->m_type = 2;
+		static_cast<Transform *>(G_pCoinMtx[k])->m_material = MATERIAL_COIN;
 
 		// Bounding boxes' initial positions and sizes
 		static_cast<Transform *>(G_pCoinMtx[k])->m_position = glm::vec3(-0.5f + static_cast<float>(randX), 0.1f + static_cast<float>(randY), 0.1726f);
 		static_cast<Transform *>(G_pCoinMtx[k])->m_size = glm::vec3(1.0f, 0.2f, 1.15f);
 
 		// Add coin as child of obstacles
-		static_cast<Transform *>(G_pObstacles)->addChild(G_pCoinMtx[k]);
+		static_cast<Transform *>(obstacleBand(randY))->addChild(G_pCoinMtx[k]);
 		static_cast<Transform *>(G_pCoinMtx[k])->addChild(G_pCoin);
 
 		// Add to obstacles list (for collision detection)
@@ -332,13 +448,14 @@ void Window::initializeObjects()
 
 		// Type for collision detection
 		static_cast<Transform *>(G_pWallMtx[k])->m_type = 3;
+		static_cast<Transform *>(G_pWallMtx[k])->m_material = MATERIAL_WALL;
 
 		// Bounding boxes' initial positions and sizes
 		static_cast<Transform *>(G_pWallMtx[k])->m_position = glm::vec3(-0.7f + static_cast<float>(randX), 0.7f + static_cast<float>(randY), 0.01f);
 		static_cast<Transform *>(G_pWallMtx[k])->m_size = glm::vec3(1.4f, 1.4f, 1.0f);
 
 		// Add wall as child of obstacles
-		static_cast<Transform *>(G_pObstacles)->addChild(G_pWallMtx[k]);
+		static_cast<Transform *>(obstacleBand(randY))->addChild(G_pWallMtx[k]);
 		static_cast<Transform *>(G_pWallMtx[k])->addChild(G_pWall);
 
 		// Add to obstacles list (for collision detection)
@@ -350,45 +467,53 @@ void Window::initializeObjects()
 
 	// Type for collision detection
 	static_cast<Transform *>(G_pWallMtx[G_nWalls])->m_type = 3;
+	static_cast<Transform *>(G_pWallMtx[G_nWalls])->m_material = MATERIAL_WALL;
 
 	// Bounding boxes' initial positions and sizes
 	static_cast<Transform *>(G_pWallMtx[G_nWalls])->m_position = glm::vec3(-0.7f, 0.7f + 2 * Window::m_nTile, 0.01f);
 	static_cast<Transform *>(G_pWallMtx[G_nWalls])->m_size = glm::vec3(1.4f, 1.4f, 1.0f);
 
 	// Add wall as child of obstacles
-	static_cast<Transform *>(G_pObstacles)->addChild(G_pWallMtx[G_nWalls]);
+	static_cast<Transform *>(obstacleBand(static_cast<float>(2 * Window::m_nTile)))->addChild(G_pWallMtx[G_nWalls]);
 	static_cast<Transform *>(G_pWallMtx[G_nWalls])->addChild(G_pWall);
 
 	// Add to obstacles list (for collision detection)
 	G_pObstaclesList.push_back(G_pWallMtx[G_nWalls]);
 
-	// Initialize obstacles' bounding boxes
-	for (const auto &obstacle : G_pObstaclesList)
-		static_cast<Transform *>(obstacle)->generateBoundingBox();
+	// Shared bounding box renderer for all obstacles
+	G_pBoundingBoxes = new BoundingBoxes(G_pObstaclesList);
 
-	// Arrange tiles to form grid
-	for (int i = -1; i <= Window::m_nTile; i++)
+	// Same objects for the GPU-driven path, all meshes in one arena
+	if (G_gpuDriven)
 	{
-		for (int j = -8; j <= 8; j++)
-		{
-			G_pTileBigPos.push_back(new Transform(glm::translate(glm::mat4(1.0f), glm::vec3(j * 2.0f, i * 2.0f, -0.1f))));
-			G_pTileSmallPos.push_back(new Transform(glm::translate(glm::mat4(1.0f), glm::vec3(j * 2.0f, i * 2.0f, 0.0f))));
-		}
+		G_pMeshArena = new MeshArena();
+		G_pSnakeIndirect = new IndirectRenderer(*G_pMeshArena);
+		G_pObstaclesIndirect = new IndirectRenderer(*G_pMeshArena);
+
+		G_pSnakeIndirect->addObject(static_cast<Transform *>(G_pHeadMtx), static_cast<Geometry *>(G_pHead));
+		for (const auto &bodyPart : G_pBodyMtx)
+			G_pSnakeIndirect->addObject(static_cast<Transform *>(bodyPart), static_cast<Geometry *>(G_pBody));
+		G_pSnakeIndirect->addObject(static_cast<Transform *>(G_pTailMtx), static_cast<Geometry *>(G_pTail));
+
+		for (int k = 0; k < G_nPyramids; k++)
+			G_pObstaclesIndirect->addObject(static_cast<Transform *>(G_pPyramidMtx[k]), static_cast<Geometry *>(G_pHead));
+		for (int k = 0; k < G_nCoins; k++)
+			G_pObstaclesIndirect->addObject(static_cast<Transform *>(G_pCoinMtx[k]), static_cast<Geometry *>(G_pCoin));
+		for (int k = 0; k <= G_nWalls; k++)
+			G_pObstaclesIndirect->addObject(static_cast<Transform *>(G_pWallMtx[k]), static_cast<Geometry *>(G_pWall));
+
+		G_pMeshArena->upload();
+		G_pSnakeIndirect->upload();
+		G_pObstaclesIndirect->upload();
+
+		for (Node *geometry : { G_pHead, G_pBody, G_pTail, G_pCoin, G_pWall })
+			MeshCache::releaseCpuData(static_cast<Geometry *>(geometry));
 	}
 
-	// Add big tiles to big grid group
-	for (const auto &bigTile : G_pTileBigPos)
-	{
-		static_cast<Transform *>(G_pGridBig)->addChild(bigTile);
-		static_cast<Transform *>(bigTile)->addChild(G_pTileBig);
-	}
+	MeshCache::report(std::cout);
 
-	// Add small tiles to small grid group
-	for (const auto &smallTile : G_pTileSmallPos)
-	{
-		static_cast<Transform *>(G_pGridSmall)->addChild(smallTile);
-		static_cast<Transform *>(smallTile)->addChild(G_pTileSmall);
-	}
+	// Ground grid; the tile pattern is computed in the shader, so its cost is independent of m_nTile
+	G_pGrid = new Grid(Window::m_nTile);
 
 	// Bezier surface 1 control points
 	glm::vec3 points0[16] = {	glm::vec3(-4,   12.50, 0.25),	// p0
@@ -466,33 +591,65 @@ void Window::initializeObjects()
 								glm::vec3(-2.5, 12.50, 3.25),	// p15
 							};
 
-	// Create 4 Bezier patches (C0 and C1 continuous)
-	patch[0] = new Bezier(points0);
-	patch[1] = new Bezier(points1);
-	patch[2] = new Bezier(points2);
-	patch[3] = new Bezier(points3);
-
-	// Surface color info
-	for (int i = 0; i < 4; i++)
-		patch[i]->m_surface = i + 1;
+	// Create 4 Bezier patches (C0 and C1 continuous), each with its own surface color
+	G_pBezier = new Bezier(tessellate);
+	G_pBezier->addPatch(points0, 1);
+	G_pBezier->addPatch(points1, 2);
+	G_pBezier->addPatch(points2, 3);
+	G_pBezier->addPatch(points3, 4);
+	G_pBezier->upload();
+
+	// Check whatever the driver finished while the scene was built
+	Shader::finishCompleted();
+
+	// Directional lights (constant, but uploaded with the rest of the frame data)
+	G_frameData.dirLight.direction	= glm::vec4(0.0f, 1.0f, 1.0f, 0.0f);
+	G_frameData.dirLight.ambient	= glm::vec4(0.2f, 0.2f, 0.2f, 0.0f);
+	G_frameData.dirLight.diffuse	= glm::vec4(1.0f, 1.0f, 1.0f, 0.0f);
+	G_frameData.dirLight.specular	= glm::vec4(0.3f, 0.3f, 0.3f, 0.0f);
+
+	G_frameData.dirLight2.direction	= glm::vec4(0.0f, 0.1f, 1.2f, 0.0f);
+	G_frameData.dirLight2.ambient	= glm::vec4(0.8f, 0.8f, 0.8f, 0.0f);
+	G_frameData.dirLight2.diffuse	= glm::vec4(0.6f, 0.6f, 0.6f, 0.0f);
+	G_frameData.dirLight2.specular	= glm::vec4(0.7f, 0.7f, 0.7f, 0.0f);
+
+	// Everything uploaded per frame (frame data, instances, indirect objects) goes through one ring
+	StreamBuffer::init(STREAM_REGION_SIZE);
+
+	// Materials never change; the block is sized for the whole table
+	glGenBuffers(1, &G_materialUBO);
+	GLState::bindBuffer(GL_UNIFORM_BUFFER, G_materialUBO);
+	glBufferData(GL_UNIFORM_BUFFER, MAX_MATERIALS * sizeof(Material), nullptr, GL_STATIC_DRAW);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(G_materials), G_materials);
+	GLState::bindBuffer(GL_UNIFORM_BUFFER, 0);
+	GLState::bindBufferBase(GL_UNIFORM_BUFFER, MATERIAL_BINDING, G_materialUBO);
+}
 
-	// Load the shader programs
-	G_gridBigShader			= LoadShaders(gridBigVertShader.c_str(),		gridBigFragShader.c_str());
-	G_gridSmallShader		= LoadShaders(gridSmallVertShader.c_str(),		gridSmallFragShader.c_str());
-	G_snakeShader			= LoadShaders(snakeVertShader.c_str(),			snakeFragShader.c_str());
-	G_obstaclesShader		= LoadShaders(obstaclesVertShader.c_str(),		obstaclesFragShader.c_str());
-	G_boundingBoxShader		= LoadShaders(boundingBoxVertShader.c_str(),	boundingBoxFragShader.c_str());
-	G_snakeContourShader	= LoadShaders(snakeContourVertShader.c_str(),	snakeContourFragShader.c_str());
-	G_bezierShader			= LoadShaders(bezierVertShader.c_str(),			bezierFragShader.c_str());
+// Upload camera, projection, fog and lights once for all programs
+void Window::updateFrameData()
+{
+	G_frameData.projection = Window::m_P;
+	G_frameData.view = Window::m_V;
+	G_frameData.camPos = glm::vec4(Window::m_camPos, 1.0f);
+	G_frameData.fog = Window::m_fog;
+	G_frameData.viewport = glm::vec2(Window::m_width, Window::m_height);
+	G_frameData.fogMin = Window::m_fogMin;
+	G_frameData.fogMax = Window::m_fogMax;
+
+	GLintptr offset = StreamBuffer::write(&G_frameData, sizeof(FrameData), StreamBuffer::m_uniformAlignment);
+	GLState::bindBufferRange(GL_UNIFORM_BUFFER, FRAME_DATA_BINDING, StreamBuffer::m_buffer, offset, sizeof(FrameData));
 }
 
 // Treat this as a destructor function. Delete dynamically allocated memory here.
 void Window::cleanUp()
 {
 	delete G_pSnake;
-	delete G_pGridBig;
-	delete G_pGridSmall;
+	delete G_pGrid;
+	delete G_pBoundingBoxes;
 	delete G_pObstacles;
+
+	for (const auto &band : G_pObstacleBands)
+		delete band;
 	delete G_pHeadMtx;
 	delete G_pTailMtx;
 
@@ -500,28 +657,30 @@ void Window::cleanUp()
 	delete G_pCoinMtx;
 	delete G_pWallMtx;
 
-	for (auto &bigTile : G_pTileBigPos)
-		delete bigTile;
-	for (auto &smallTile : G_pTileSmallPos)
-		delete smallTile;
 	for (auto &bodyPart : G_pBodyMtx)
 		delete bodyPart;
 
-	delete G_pHead;
-	delete G_pBody;
-	delete G_pTail;
-	delete G_pTileBig;
-	delete G_pTileSmall;
-	delete G_pCoin;
-	delete G_pWall;
-
-	glDeleteProgram(G_gridBigShader);
-	glDeleteProgram(G_gridSmallShader);
-	glDeleteProgram(G_snakeShader);
-	glDeleteProgram(G_obstaclesShader);
-	glDeleteProgram(G_boundingBoxShader);
-	glDeleteProgram(G_snakeContourShader);
-	glDeleteProgram(G_bezierShader);
+	for (Node *geometry : { G_pHead, G_pBody, G_pTail, G_pCoin, G_pWall })
+		MeshCache::release(static_cast<Geometry *>(geometry));
+
+	delete G_pBezier;
+
+	delete G_pSnakeIndirect;
+	delete G_pObstaclesIndirect;
+	delete G_pMeshArena;
+
+	delete G_gridShader;
+	delete G_snakeShader;
+	delete G_obstaclesShader;
+	delete G_boundingBoxShader;
+	delete G_snakeContourShader;
+	delete G_bezierShader;
+	delete G_cullShader;
+	delete G_snakeIndirectShader;
+	delete G_obstaclesIndirectShader;
+
+	StreamBuffer::cleanUp();
+	GLState::deleteBuffers(1, &G_materialUBO);
 }
 
 // Since everything is on the grid, no need of collision-check in z-direction
@@ -567,7 +726,7 @@ void Window::performCollisions()
 				{
 					G_collisionSound->Play("./audio/bleep.wav");
 					static_cast<Transform *>(*it)->m_bboxColor = 3;
-					static_cast<Transform *>(*it)->m_destroyed = true;
+					static_cast<Transform *>(*it)->destroy();
 				}
 			}
 		}
@@ -635,39 +794,56 @@ GLFWwindow* Window::createWindow()
 
 void Window::displayCallback(GLFWwindow *window)
 {
+	GLState::resetCounters();
+
+	// Claim this frame's part of the stream buffer before anything is written to it
+	StreamBuffer::beginFrame();
+
+	// Pick up programs that finished compiling in the background (the rest wait until first used)
+	Shader::finishCompleted();
+
 	// Clear the color and depth buffers
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-	// Using GridBigShader, draw black background
-	glUseProgram(G_gridBigShader);
-	G_pGridBig->draw(G_gridBigShader, Window::m_V);
+	// Per-frame uniforms shared by every program
+	Window::updateFrameData();
 
-	// Using GridSmallShader, draw small white tiles
-	glUseProgram(G_gridSmallShader);
-	G_pGridSmall->draw(G_gridSmallShader, Window::m_V);
+	// Refresh the scene's world-space bounds (only moved subtrees are revisited) and set the culling frustum
+	// With fog on, anything past full-fog distance is indistinguishable from the clear color
+	Transform::beginFrame(Window::m_P * Window::m_V, Window::m_camPos, Window::m_fog ? Window::m_fogMax : 0.0f);
+	G_pSnake->bounds(glm::mat4(1.0f), false);
+	G_pObstacles->bounds(glm::mat4(1.0f), false);
 
-	// Using SnakeShader, draw snake
-	glUseProgram(G_snakeShader);
-	G_pSnake->draw(G_snakeShader, Window::m_V);
+	// Programs specialised for the fog setting
+	const std::string fog = Window::m_fog ? "FOG" : "";
 
-	// Using SnakeContourShader, draw outline of snake
-	glUseProgram(G_snakeContourShader);
-	static_cast<Transform *>(G_pSnake)->drawSnakeContour(G_snakeContourShader, Window::m_V);
+	// Snake and obstacles: either culled on the GPU and drawn with one indirect multi-draw each,
+	// or culled by the scene graph; both go through the queue
+	if (G_gpuDriven)
+	{
+		G_pSnakeIndirect->draw(*G_cullShader, G_snakeIndirectShader->variant(fog));
+		G_pObstaclesIndirect->draw(*G_cullShader, G_obstaclesIndirectShader->variant(fog));
+	}
+	else
+	{
+		G_pSnake->draw(G_snakeShader->variant(fog), Window::m_V, MATERIAL_DEFAULT);
+		G_pObstacles->draw(G_obstaclesShader->variant(fog), Window::m_V, MATERIAL_DEFAULT);
+	}
 
-	// Using ObstaclesShader, draw the obstacles
-	glUseProgram(G_obstaclesShader);
-	G_pObstacles->draw(G_obstaclesShader, Window::m_V);
+	// Submit everything else; nothing reaches GL until the queue is flushed
+	G_pGrid->draw(G_gridShader->variant(fog), Window::m_V);
+	static_cast<Transform *>(G_pSnake)->drawSnakeContour(G_snakeContourShader->variant(fog), Window::m_V);
 
-	// Using BoundingBoxShader, draw the axis-aligned bounding boxes (AABB)
-	glUseProgram(G_boundingBoxShader);
 	if (G_drawBbox)
-		for (const auto &obstacle : G_pObstaclesList)
-			static_cast<Transform *>(obstacle)->drawBoundingBox(G_boundingBoxShader, Window::m_V);
+		G_pBoundingBoxes->draw(G_boundingBoxShader->variant(fog), Window::m_V);
+
+	if (Transform::visible(G_pBezier->bounds()))
+		G_pBezier->draw(G_bezierShader->variant(fog), Window::m_V);
 
-	// Using BezierShader, draw the 4 Bezier surfaces
-	glUseProgram(G_bezierShader);
-	for (int i = 0; i < 4; i++)
-		patch[i]->draw(G_bezierShader);
+	// Sorted by pass, program, mesh and depth; items sharing a program and mesh become one instanced draw
+	// (opaque and ground passes are drawn twice when the depth pre-pass is on)
+	RenderQueue::flush();
+	StreamBuffer::endFrame();
 
 	// Gets events, including input such as keyboard and mouse or window resizing
 	glfwPollEvents();
@@ -715,7 +891,6 @@ void Window::idleCallback()
 		static_cast<Transform *>(G_pCoinMtx[i])->m_size.x = abs(2.0f * static_cast<Transform *>(G_pCoinMtx[i])->m_position.x);
 		static_cast<Transform *>(G_pCoinMtx[i])->m_size.y = abs(2.0f * static_cast<Transform *>(G_pCoinMtx[i])->m_position.y);
 		static_cast<Transform *>(G_pCoinMtx[i])->m_position.y += 14.1f;
-		static_cast<Transform *>(G_pCoinMtx[i])->generateBoundingBox();
 	}
 
 	// Update camera pos, lookat and snake pos
@@ -725,8 +900,6 @@ void Window::idleCallback()
 
 	// Update head's bounding box position
 	static_cast<Transform *>(G_pHeadMtx)->m_position.y += Window::m_velocity;
-	static_cast<Transform *>(G_pHeadMtx)->generateBoundingBox();
-	static_cast<Transform *>(G_pSnake)->generateSnakeContour();
 
 	// Perform collision check
 	performCollisions();
@@ -746,11 +919,21 @@ void Window::resizeCallback(GLFWwindow *window, int width, int height)
 
 	if (height > 0)
 	{
-		Window::m_P = glm::perspective(45.0f, static_cast<float>(width) / static_cast<float>(height), 0.1f, 2000.0f);
+		Window::updateProjection();
 		Window::m_V = glm::lookAt(Window::m_camPos, G_camLookAt, G_camUp);
 	}
 }
 
+// While fog is on nothing past full-fog distance is visible, so the far plane can stop there
+void Window::updateProjection()
+{
+	if (Window::m_height <= 0)
+		return;
+
+	float farPlane = Window::m_fog ? Window::m_fogMax : 2000.0f;
+	Window::m_P = glm::perspective(45.0f, static_cast<float>(Window::m_width) / static_cast<float>(Window::m_height), 0.1f, farPlane);
+}
+
 void Window::keyCallback(GLFWwindow *window, int key, int scanCode, int action, int mods)
 {
 	if (action == GLFW_PRESS || action == GLFW_REPEAT)
@@ -764,6 +947,7 @@ void Window::keyCallback(GLFWwindow *window, int key, int scanCode, int action,
 			// Toggle fog
 			case GLFW_KEY_F:
 				Window::m_fog = !Window::m_fog;
+				Window::updateProjection();
 				break;
 
 			// Toggle Bounding boxes
@@ -771,6 +955,21 @@ void Window::keyCallback(GLFWwindow *window, int key, int scanCode, int action,
 				G_drawBbox = !G_drawBbox;
 				break;
 
+			// Toggle GPU-driven rendering (if it was set up)
+			case GLFW_KEY_G:
+				G_gpuDriven = !G_gpuDriven && G_pMeshArena;
+				break;
+
+			// Toggle the depth pre-pass
+			case GLFW_KEY_Z:
+				RenderQueue::m_depthPrepass = !RenderQueue::m_depthPrepass;
+				break;
+
+			// Toggle frame statistics in the console
+			case GLFW_KEY_I:
+				Window::m_showStats = !Window::m_showStats;
+				break;
+
 			// Accelerate
 			case GLFW_KEY_UP:
 			case GLFW_KEY_W:
@@ -49,6 +49,8 @@
 #include <GLFW/glfw3.h>
 
 #include "Bezier.h"
+#include "Grid.h"
+#include "IndirectRenderer.h"
 #include "SceneGraph.h"
 #include "Shader.h"
 
@@ -75,7 +77,11 @@ public:
 	static void mouseButtonCallback(GLFWwindow *window, int button, int action, int mods);
 	static void scrollCallback(GLFWwindow *window, double xOffset, double yOffset);
 
+	static void updateProjection();
+
 private:
+	static void updateFrameData();
+
 	static float randGenX();
 	static float randGenY();
 
@@ -95,6 +101,10 @@ public:
 	static glm::mat4 m_V;	// V for view
 
 	static bool m_fog;
+	static float m_fogMin;		// Fog starts at this distance from the eye
+	static float m_fogMax;		// Nothing is visible beyond this distance while fog is on
+
+	static bool m_showStats;	// Print frame rate and renderer counters to the console
 };
 
 #endif
@@ -29,6 +29,7 @@
  **/
 
 #include "snakesGL.h"
+#include "StreamBuffer.h"
 
 GLFWwindow *G_window;
 
@@ -120,7 +121,8 @@ void printVersions()
 	std::cout << "Maximum number of vertex attributes supported: " << numVertexAttribsSupprted << std::endl;
 }
 
-// Display FPS (Frames per second)
+// Display FPS (Frames per second) and the renderer's counters for the last frame, once a second
+// while Window::m_showStats is on (toggled with I)
 void showFPS()
 {
 	float currTicks = static_cast<float>(clock());
@@ -151,7 +153,19 @@ void showFPS()
 		fps = 60.0f;
 
 	currFrame++;
-	std::cout << "\r" << fps << std::flush;
+
+	// Frame times are sampled every frame so the average is ready when printing is turned on
+	static double prevPrint = 0.0;
+	double now = glfwGetTime();
+	if (!Window::m_showStats || now - prevPrint < 1.0)
+		return;
+
+	prevPrint = now;
+	std::cout << fps << " fps" << std::endl;
+	std::cout << "  culling: transforms drawn/culled " << Transform::m_nVisited << "/" << Transform::m_nCulled << std::endl;
+	std::cout << "  render queue: draw items/batches " << RenderQueue::m_nItems << "/" << RenderQueue::m_nBatches << (RenderQueue::m_depthPrepass ? " (depth pre-pass)" : "") << std::endl;
+	std::cout << "  GL state: calls issued/elided " << GLState::m_nIssued << "/" << GLState::m_nElided << std::endl;
+	std::cout << "  stream buffer: waits since start " << StreamBuffer::m_nWaits << std::endl;
 }
 
 int main(int argc, char **argv)
@@ -179,10 +193,9 @@ int main(int argc, char **argv)
 
 		// Idle callback. Updating objects, etc. can be done here.
 		Window::idleCallback();
-		//showFPS();
+		showFPS();
 	}
 
-	std::cout << std::endl;
 	Window::cleanUp();
 
 	// Destroy the window